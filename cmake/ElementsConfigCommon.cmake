@@ -41,11 +41,11 @@ endif()
 # UI Libraries
 
 if(WIN32)
-    set(ELEMENTS_HOST_UI_LIBRARY "win32" CACHE STRING "gtk, cocoa or win32")
+    set(ELEMENTS_HOST_UI_LIBRARY "win32" CACHE STRING "gtk, cocoa, win32 or headless")
 elseif(UNIX AND NOT APPLE)
-    set(ELEMENTS_HOST_UI_LIBRARY "gtk" CACHE STRING "gtk, cocoa or win32")
+    set(ELEMENTS_HOST_UI_LIBRARY "gtk" CACHE STRING "gtk, cocoa, win32 or headless")
 elseif(APPLE)
-    set(ELEMENTS_HOST_UI_LIBRARY "cocoa" CACHE STRING "gtk, cocoa or win32")
+    set(ELEMENTS_HOST_UI_LIBRARY "cocoa" CACHE STRING "gtk, cocoa, win32 or headless")
 endif()
 
 message(STATUS "building elements with ${ELEMENTS_HOST_UI_LIBRARY} host UI library")
@@ -6,17 +6,16 @@
 #include <elements.hpp>
 
 using namespace cycfi::elements;
-using namespace std::chrono_literals;
 
 float position = 0.0;
-constexpr float incr = 0.001;
-constexpr auto fps = 1000ms / 60;
+constexpr float speed = 0.06;    // per second
 
-void animate(view& view_, vport_element& port)
+void animate(view& view_, vport_element& port, view::frame_time start, view::frame_time now)
 {
-   position += incr;
+   std::chrono::duration<float> elapsed = now - start;
+   position = elapsed.count() * speed;
    if (position < 1.0)
-      view_.post(fps, [&]() { animate(view_, port); });
+      view_.request_frame([&, start](auto time) { animate(view_, port, start, time); });
    else
       position = 1.0;
    port.valign(position);
@@ -34,7 +33,7 @@ int main(int argc, char* argv[])
    auto port = share(vport(image{ "moving.png" }));
    view_.content(port);
 
-   view_.post(fps, [&]() { animate(view_, *port); });
+   view_.request_frame([&](auto time) { animate(view_, *port, time, time); });
 
    _app.run();
    return 0;
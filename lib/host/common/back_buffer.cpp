@@ -0,0 +1,126 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#include "back_buffer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace cycfi::elements
+{
+	void render_damage(base_view& view, cairo_surface_t* surface, cairo_region_t*& damage)
+	{
+		auto* taken = damage;
+		damage = cairo_region_create();
+
+		cairo_rectangle_int_t extents;
+		cairo_region_get_extents(taken, &extents);
+
+		auto* cr = cairo_create(surface);
+		for (int i = 0, n = cairo_region_num_rectangles(taken); i != n; ++i)
+		{
+			cairo_rectangle_int_t r;
+			cairo_region_get_rectangle(taken, i, &r);
+			cairo_rectangle(cr, r.x, r.y, r.width, r.height);
+		}
+		cairo_clip(cr);
+		cairo_region_destroy(taken);
+
+		// Clear the damaged area before drawing over it
+		cairo_save(cr);
+		cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+		cairo_paint(cr);
+		cairo_restore(cr);
+
+		view.draw(
+			cr,
+			{
+				static_cast<rect::coordinate_type>(extents.x),
+				static_cast<rect::coordinate_type>(extents.y),
+				static_cast<rect::coordinate_type>(extents.x + extents.width),
+				static_cast<rect::coordinate_type>(extents.y + extents.height)
+			}
+		);
+		cairo_destroy(cr);
+	}
+
+	bool scroll_back_buffer(
+		cairo_surface_t* surface, int width, int height
+	  , cairo_region_t* damage, rect area, point offset
+	  , cairo_rectangle_int_t& outer
+	)
+	{
+		// Only whole pixel shifts can be done by copying. Allow for rounding
+		// errors from the user to device transform.
+		int dx = static_cast<int>(std::lround(offset.x));
+		int dy = static_cast<int>(std::lround(offset.y));
+		if (std::abs(offset.x - dx) > 0.01f || std::abs(offset.y - dy) > 0.01f)
+			return false;
+
+		// The pixels on the edges of a fractional area are shared with its
+		// surroundings. Copy only the whole pixels inside the area.
+		cairo_rectangle_int_t bounds = { 0, 0, width, height };
+		auto* inner = cairo_region_create_rectangle(&bounds);
+		{
+			auto left = static_cast<int>(std::ceil(area.left));
+			auto top = static_cast<int>(std::ceil(area.top));
+			auto right = static_cast<int>(std::floor(area.right));
+			auto bottom = static_cast<int>(std::floor(area.bottom));
+			cairo_rectangle_int_t r = { left, top, std::max(right - left, 0), std::max(bottom - top, 0) };
+			cairo_region_intersect_rectangle(inner, &r);
+		}
+
+		// The destination of the copy: the shifted area, within the area
+		auto* dest = cairo_region_copy(inner);
+		cairo_region_translate(dest, dx, dy);
+		cairo_region_intersect(dest, inner);
+
+		if (cairo_region_is_empty(dest))
+		{
+			// Scrolled by a whole page or more: nothing can be reused
+			cairo_region_destroy(dest);
+			cairo_region_destroy(inner);
+			return false;
+		}
+
+		cairo_rectangle_int_t dest_r;
+		cairo_region_get_extents(dest, &dest_r);
+
+		// Copy through a group, since the source and destination overlap
+		auto* cr = cairo_create(surface);
+		cairo_rectangle(cr, dest_r.x, dest_r.y, dest_r.width, dest_r.height);
+		cairo_clip(cr);
+		cairo_push_group(cr);
+		cairo_set_source_surface(cr, surface, dx, dy);
+		cairo_paint(cr);
+		cairo_pop_group_to_source(cr);
+		cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+		cairo_paint(cr);
+		cairo_destroy(cr);
+
+		// Damage that was not rendered yet moved along with the pixels
+		auto* moved = cairo_region_copy(damage);
+		cairo_region_intersect(moved, inner);
+		cairo_region_translate(moved, dx, dy);
+		cairo_region_intersect(moved, inner);
+		cairo_region_union(damage, moved);
+		cairo_region_destroy(moved);
+
+		// Everything else in the area needs to be rendered
+		auto left = static_cast<int>(std::floor(area.left));
+		auto top = static_cast<int>(std::floor(area.top));
+		auto right = static_cast<int>(std::ceil(area.right));
+		auto bottom = static_cast<int>(std::ceil(area.bottom));
+		outer = { left, top, right - left, bottom - top };
+
+		auto* exposed = cairo_region_create_rectangle(&outer);
+		cairo_region_subtract(exposed, dest);
+		cairo_region_union(damage, exposed);
+		cairo_region_destroy(exposed);
+		cairo_region_destroy(dest);
+		cairo_region_destroy(inner);
+		return true;
+	}
+}
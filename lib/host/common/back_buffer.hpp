@@ -0,0 +1,38 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#if !defined(ELEMENTS_HOST_BACK_BUFFER_OCTOBER_17_2026)
+#define ELEMENTS_HOST_BACK_BUFFER_OCTOBER_17_2026
+
+#include <elements/base_view.hpp>
+#include <cairo.h>
+
+namespace cycfi::elements
+{
+	////////////////////////////////////////////////////////////////////////////
+	// Retained back buffer support, shared by the hosts that render into a
+	// cairo surface they keep, along with the region of it that needs to be
+	// re-rendered (the damage).
+	////////////////////////////////////////////////////////////////////////////
+
+	// Render the damaged parts of the back buffer. The damage is taken
+	// first, leaving an empty region: elements may call refresh while
+	// drawing, and that damage is rendered in the next frame.
+	void render_damage(base_view& view, cairo_surface_t* surface, cairo_region_t*& damage);
+
+	// Shift the pixels of area (in device coordinates) by offset, within
+	// the area, and add what needs to be re-rendered to the damage. Pending
+	// damage moves along with the pixels. Returns false, without changing
+	// anything, if the pixels cannot be reused: the offset is not a whole
+	// number of pixels, or it is as large as the area. Otherwise, outer is
+	// set to the area rounded outwards to whole pixels.
+	bool scroll_back_buffer(
+		cairo_surface_t* surface, int width, int height
+	  , cairo_region_t* damage, rect area, point offset
+	  , cairo_rectangle_int_t& outer
+	);
+}
+
+#endif
@@ -0,0 +1,77 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/app.hpp>
+#include <elements/support/font.hpp>
+#include <elements/support/resource_paths.hpp>
+#include <infra/filesystem.hpp>
+#include <string>
+
+namespace cycfi { namespace elements
+{
+   // Defined in base_view.cpp
+   void run_views(std::atomic<bool> const& running);
+   void wake_views();
+
+   namespace
+   {
+      fs::path find_resources(char* argv0)
+      {
+         const fs::path app_path = fs::path(argv0 ? argv0 : "");
+         const fs::path app_dir = app_path.parent_path();
+
+         if (app_dir.filename() == "bin")
+         {
+            fs::path path = app_dir.parent_path() / "share" / app_path.filename() / "resources";
+            if (fs::is_directory(path))
+               return path;
+         }
+
+         const fs::path app_resources_dir = app_dir / "resources";
+         if (fs::is_directory(app_resources_dir))
+            return app_resources_dir;
+
+         return fs::current_path() / "resources";
+      }
+
+      struct init_app
+      {
+         init_app(char* argv0)
+         {
+            const fs::path resources_path = find_resources(argv0);
+            font_paths().push_back(resources_path);
+            add_search_path(resources_path);
+         }
+      };
+   }
+
+   app::app(
+      int         argc
+    , char*       argv[]
+    , std::string name
+    , std::string /* id */
+   )
+   : _app_name(name)
+   {
+      static init_app init{ argc > 0 ? argv[0] : nullptr };
+   }
+
+   app::~app()
+   {
+   }
+
+   int app::run()
+   {
+      // Poll and render the views until stopped
+      run_views(_running);
+      return 0;
+   }
+
+   void app::stop()
+   {
+      _running = false;
+      wake_views();
+   }
+}}
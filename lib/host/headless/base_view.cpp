@@ -0,0 +1,361 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#include <elements/base_view.hpp>
+#include <elements/window.hpp>
+#include <elements/support/resource_paths.hpp>
+#include "../common/back_buffer.hpp"
+#include <infra/filesystem.hpp>
+#include <cairo.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace cycfi::elements
+{
+	struct host_view
+	{
+		host_view() : damage(cairo_region_create()) {}
+
+		~host_view()
+		{
+			if (surface)
+				cairo_surface_destroy(surface);
+			cairo_region_destroy(damage);
+		}
+
+		// The rendered frame and the regions of it that need to be
+		// re-rendered (accumulated by base_view::refresh).
+		cairo_surface_t* surface = nullptr;
+		int width = 0;
+		int height = 0;
+		cairo_region_t* damage;
+
+		point cursor_position;
+		bool cursor_inside = false;
+	};
+
+	point get_window_size(host_window& h);
+
+	namespace
+	{
+		cursor_type view_cursor_type = cursor_type::arrow;
+		std::string clipboard_text;
+
+		void resize_surface(host_view* h, int width, int height)
+		{
+			width = std::max(width, 1);
+			height = std::max(height, 1);
+			if (h->surface && width == h->width && height == h->height)
+				return;
+
+			if (h->surface)
+				cairo_surface_destroy(h->surface);
+			h->surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+			h->width = width;
+			h->height = height;
+
+			// The new surface is blank: everything needs to be rendered
+			cairo_rectangle_int_t all = { 0, 0, width, height };
+			cairo_region_union_rectangle(h->damage, &all);
+		}
+
+		// The run loop used by app::run. Views are polled when they ask for
+		// it (base_view::schedule_poll), or when their deadline is reached.
+		class run_loop
+		{
+		public:
+
+			static run_loop& instance()
+			{
+				static run_loop loop;
+				return loop;
+			}
+
+			void attach(base_view& view)
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_views.insert(&view);
+			}
+
+			void detach(base_view& view)
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_views.erase(&view);
+			}
+
+			void wake()
+			{
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					_woken = true;
+				}
+				_cv.notify_one();
+			}
+
+			void wake(std::chrono::steady_clock::time_point deadline)
+			{
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					_deadlines.insert(deadline);
+				}
+				_cv.notify_one();
+			}
+
+			void run(std::atomic<bool> const& running)
+			{
+				while (running)
+				{
+					std::vector<base_view*> views;
+					{
+						std::unique_lock<std::mutex> lock(_mutex);
+						auto ready = [this, &running]{ return _woken || !running; };
+						if (_deadlines.empty())
+							_cv.wait(lock, ready);
+						else
+							_cv.wait_until(lock, *_deadlines.begin(), ready);
+
+						_woken = false;
+						_deadlines.erase(
+							_deadlines.begin()
+						  , _deadlines.upper_bound(std::chrono::steady_clock::now())
+						);
+						views.assign(_views.begin(), _views.end());
+					}
+
+					for (auto* view : views)
+					{
+						// The view may be gone, destroyed by the previous one
+						{
+							std::lock_guard<std::mutex> lock(_mutex);
+							if (_views.find(view) == _views.end())
+								continue;
+						}
+						headless::frame(*view);
+					}
+				}
+			}
+
+		private:
+
+			std::mutex _mutex;
+			std::condition_variable _cv;
+			std::set<base_view*> _views;
+			std::multiset<std::chrono::steady_clock::time_point> _deadlines;
+			bool _woken = true;
+		};
+
+		struct init_view_class
+		{
+			init_view_class()
+			{
+				auto pwd = fs::current_path();
+				auto resource_path = pwd / "resources";
+				add_search_path(resource_path);
+			}
+		};
+	}
+
+	// Used by app::run and app::stop
+	void run_views(std::atomic<bool> const& running)
+	{
+		run_loop::instance().run(running);
+	}
+
+	void wake_views()
+	{
+		run_loop::instance().wake();
+	}
+
+	base_view::base_view(extent size) : base_view(new host_view)
+	{
+		resize(size);
+	}
+
+	base_view::base_view(host_view_handle h) : _view(h)
+	{
+		static init_view_class init;
+		run_loop::instance().attach(*this);
+	}
+
+	base_view::base_view(host_window_handle h) : base_view(new host_view)
+	{
+		auto size = get_window_size(*h);
+		resize({ size.x, size.y });
+	}
+
+	base_view::~base_view()
+	{
+		run_loop::instance().detach(*this);
+		delete _view;
+	}
+
+	point base_view::cursor_pos() const
+	{
+		return _view->cursor_position;
+	}
+
+	elements::extent base_view::size() const
+	{
+		return { static_cast<extent::size_type>(_view->width), static_cast<extent::size_type>(_view->height) };
+	}
+
+	void base_view::resize(elements::extent new_size)
+	{
+		resize_surface(_view, std::lround(new_size.width), std::lround(new_size.height));
+		schedule_poll();
+	}
+
+	float base_view::hdpi_scale() const
+	{
+		unused(this);
+		return 1.0f;
+	}
+
+	void base_view::refresh()
+	{
+		refresh({ 0, 0, static_cast<rect::coordinate_type>(_view->width), static_cast<rect::coordinate_type>(_view->height) });
+	}
+
+	void base_view::refresh(rect area)
+	{
+		// Round outwards to whole pixels and add it to the damage that will
+		// be rendered at the next frame.
+		auto left = static_cast<int>(std::floor(area.left));
+		auto top = static_cast<int>(std::floor(area.top));
+		auto right = static_cast<int>(std::ceil(area.right));
+		auto bottom = static_cast<int>(std::ceil(area.bottom));
+		if (right <= left || bottom <= top)
+			return;
+
+		cairo_rectangle_int_t r = { left, top, right - left, bottom - top };
+		cairo_region_union_rectangle(_view->damage, &r);
+		schedule_poll();
+	}
+
+	bool base_view::scroll_area(rect area, point offset)
+	{
+		cairo_rectangle_int_t outer;
+		if (!scroll_back_buffer(
+				_view->surface, _view->width, _view->height
+			  , _view->damage, area, offset, outer))
+			return false;
+
+		schedule_poll();
+		return true;
+	}
+
+	void base_view::schedule_poll()
+	{
+		run_loop::instance().wake();
+	}
+
+	void base_view::schedule_poll(std::chrono::steady_clock::time_point deadline)
+	{
+		run_loop::instance().wake(deadline);
+	}
+
+	bool base_view::request_tick()
+	{
+		// No display, hence no frame clock: the view falls back to a fixed
+		// rate timer
+		return false;
+	}
+
+	namespace headless
+	{
+		bool frame(base_view& view)
+		{
+			auto* h = view.host();
+			view.poll();
+
+			if (cairo_region_is_empty(h->damage))
+				return false;
+
+			render_damage(view, h->surface, h->damage);
+			cairo_surface_flush(h->surface);
+			return true;
+		}
+
+		cairo_surface_t* surface(base_view& view)
+		{
+			return view.host()->surface;
+		}
+
+		cursor_type current_cursor()
+		{
+			return view_cursor_type;
+		}
+
+		void mouse_move(base_view& view, point p)
+		{
+			auto* h = view.host();
+			h->cursor_position = p;
+			if (!h->cursor_inside)
+			{
+				h->cursor_inside = true;
+				view.cursor(p, cursor_tracking::entering);
+			}
+			else
+			{
+				view.cursor(p, cursor_tracking::hovering);
+			}
+		}
+
+		void mouse_leave(base_view& view)
+		{
+			auto* h = view.host();
+			if (h->cursor_inside)
+			{
+				h->cursor_inside = false;
+				view.cursor(h->cursor_position, cursor_tracking::leaving);
+			}
+		}
+
+		void click(base_view& view, mouse_button btn)
+		{
+			view.host()->cursor_position = btn.pos;
+			view.click(btn);
+		}
+
+		void drag(base_view& view, mouse_button btn)
+		{
+			view.host()->cursor_position = btn.pos;
+			view.drag(btn);
+		}
+
+		void scroll(base_view& view, point dir, point p)
+		{
+			view.host()->cursor_position = p;
+			view.scroll(dir, p);
+		}
+	}
+
+	std::string clipboard()
+	{
+		return clipboard_text;
+	}
+
+	void clipboard(const std::string & text)
+	{
+		clipboard_text = text;
+	}
+
+	void set_cursor(cursor_type type)
+	{
+		view_cursor_type = type;
+	}
+
+	point scroll_direction()
+	{
+		return { +1, +1 };
+	}
+}
+
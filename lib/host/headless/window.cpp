@@ -0,0 +1,61 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#include <elements/window.hpp>
+#include <elements/support.hpp>
+
+namespace cycfi { namespace elements
+{
+   // There is no display. The window simply keeps its geometry, which is
+   // used to size the views created in it.
+   struct host_window
+   {
+      point       position;
+      point       size;
+      view_limits limits;
+   };
+
+   point get_window_size(host_window& h)
+   {
+      return h.size;
+   }
+
+   window::window(std::string const& /* name */, int /* style_ */, rect const& bounds)
+    :  _window(new host_window)
+   {
+      position(bounds.left_top());
+      size(bounds.right_bottom());
+   }
+
+   window::~window()
+   {
+      delete _window;
+   }
+
+   point window::size() const
+   {
+      return _window->size;
+   }
+
+   void window::size(point const& p)
+   {
+      _window->size = p;
+   }
+
+   void window::limits(view_limits limits_)
+   {
+      _window->limits = limits_;
+   }
+
+   point window::position() const
+   {
+      return _window->position;
+   }
+
+   void window::position(point const& p)
+   {
+      _window->position = p;
+   }
+}}
@@ -11,25 +11,43 @@
 #include <elements/support/canvas.hpp>
 #include <elements/support/resource_paths.hpp>
 #include <elements/support/text_utils.hpp>
+#include "../common/back_buffer.hpp"
 #include <gtk/gtk.h>
+#include <glib-unix.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
 #include <map>
+#include <mutex>
+#include <set>
 #include <string>
+#include <vector>
 
 namespace cycfi::elements
 {
 	struct host_view
 	{
-		host_view() : im_context(gtk_im_context_simple_new()) {}
+		host_view()
+			: damage(cairo_region_create()), im_context(gtk_im_context_simple_new()) {}
 
 		~host_view()
 		{
 			if(surface)
 				cairo_surface_destroy(surface);
 			surface = nullptr;
+			cairo_region_destroy(damage);
 		}
 
+		// The retained back buffer and the regions of it that need to be
+		// re-rendered (accumulated by base_view::refresh).
 		cairo_surface_t* surface = nullptr;
+		int surface_width = 0;
+		int surface_height = 0;
+		cairo_region_t* damage;
+
 		GtkWidget* widget = nullptr;
+		guint tick_id = 0;
 
 		// Mouse button click tracking
 		std::uint32_t click_time = 0;
@@ -69,43 +87,56 @@ namespace cycfi::elements
 			return *reinterpret_cast<base_view*>(user_data);
 		}
 
-		gboolean on_configure(GtkWidget* widget, GdkEventConfigure* /* event */, gpointer user_data)
+		void resize_back_buffer(GtkWidget* widget, host_view* host_view_h)
 		{
-			auto& view = get(user_data);
-			auto* host_view_h = platform_access::get_host_view(view);
+			auto width = gtk_widget_get_allocated_width(widget);
+			auto height = gtk_widget_get_allocated_height(widget);
+
+			// Configure events are also sent when the window is moved. Keep
+			// the back buffer unless the size actually changed.
+			if (host_view_h->surface
+				&& width == host_view_h->surface_width
+				&& height == host_view_h->surface_height)
+				return;
 
 			if (host_view_h->surface)
 				cairo_surface_destroy(host_view_h->surface);
 
 			host_view_h->surface = gdk_window_create_similar_surface(
 					gtk_widget_get_window(widget), CAIRO_CONTENT_COLOR,
-					gtk_widget_get_allocated_width(widget),
-					gtk_widget_get_allocated_height(widget)
+					width, height
 					);
+			host_view_h->surface_width = width;
+			host_view_h->surface_height = height;
+
+			// The new back buffer is blank: everything needs to be rendered
+			cairo_rectangle_int_t all = { 0, 0, width, height };
+			cairo_region_union_rectangle(host_view_h->damage, &all);
+		}
+
+		gboolean on_configure(GtkWidget* widget, GdkEventConfigure* /* event */, gpointer user_data)
+		{
+			auto& view = get(user_data);
+			resize_back_buffer(widget, platform_access::get_host_view(view));
 			return true;
 		}
 
-		gboolean on_draw(GtkWidget* /* widget */, cairo_t* cr, gpointer user_data)
+		gboolean on_draw(GtkWidget* widget, cairo_t* cr, gpointer user_data)
 		{
 			auto& view = get(user_data);
 			auto* host_view_h = platform_access::get_host_view(view);
-			cairo_set_source_surface(cr, host_view_h->surface, 0, 0);
-			cairo_paint(cr);
+			resize_back_buffer(widget, host_view_h);
+
+			// Render only what was damaged since the last draw. Exposes that
+			// are not caused by a refresh (e.g. the window was uncovered) have
+			// no damage and are served from the back buffer.
+			if (!cairo_region_is_empty(host_view_h->damage))
+				render_damage(view, host_view_h->surface, host_view_h->damage);
 
 			// Note that cr (cairo_t) is already clipped to only draw the
 			// exposed areas of the widget.
-			double left, top, right, bottom;
-			cairo_clip_extents(cr, &left, &top, &right, &bottom);
-			view.draw(
-					cr,
-					{
-							static_cast<rect::coordinate_type>(left),
-							static_cast<rect::coordinate_type>(top),
-							static_cast<rect::coordinate_type>(right),
-							static_cast<rect::coordinate_type>(bottom)
-					}
-            );
-
+			cairo_set_source_surface(cr, host_view_h->surface, 0, 0);
+			cairo_paint(cr);
 			return false;
 		}
 
@@ -265,6 +296,142 @@ namespace cycfi::elements
 		}
 	}
 
+	namespace
+	{
+		////////////////////////////////////////////////////////////////////////
+		// io_pump: drives the views' io_contexts from the GLib main loop.
+		//
+		// One eventfd, shared by all views in the process, wakes the main
+		// loop whenever work is posted. Timer deadlines are fed into a single
+		// one-shot GLib timeout armed for the earliest one. An idle view
+		// costs no wakeups at all.
+		////////////////////////////////////////////////////////////////////////
+		class io_pump
+		{
+		public:
+			using clock = std::chrono::steady_clock;
+			using time_point = clock::time_point;
+
+			static io_pump& instance()
+			{
+				static io_pump pump;
+				return pump;
+			}
+
+			void attach(base_view& view)
+			{
+				_views.push_back(&view);
+			}
+
+			void detach(base_view& view)
+			{
+				_views.erase(std::remove(_views.begin(), _views.end(), &view), _views.end());
+			}
+
+			void wake()
+			{
+				std::uint64_t one = 1;
+				auto r = write(_fd, &one, sizeof(one));
+				unused(r);
+			}
+
+			void wake(time_point deadline)
+			{
+				bool rearm;
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					rearm = _deadlines.empty() || deadline < *_deadlines.begin();
+					_deadlines.insert(deadline);
+				}
+				if (rearm)
+					wake();
+			}
+
+		private:
+			io_pump()
+				: _fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+			{
+				_fd_source_id = g_unix_fd_add(_fd, G_IO_IN, on_wake, this);
+			}
+
+			~io_pump()
+			{
+				if (_timeout_id)
+					g_source_remove(_timeout_id);
+				if (_fd_source_id)
+					g_source_remove(_fd_source_id);
+				if (_fd != -1)
+					close(_fd);
+			}
+
+			static gboolean on_wake(gint fd, GIOCondition /* condition */, gpointer user_data)
+			{
+				std::uint64_t count;
+				auto r = read(fd, &count, sizeof(count));
+				unused(r);
+
+				auto& pump = *reinterpret_cast<io_pump*>(user_data);
+				pump.poll_views();
+				pump.arm_timeout();
+				return G_SOURCE_CONTINUE;
+			}
+
+			static gboolean on_timeout(gpointer user_data)
+			{
+				auto& pump = *reinterpret_cast<io_pump*>(user_data);
+				{
+					std::lock_guard<std::mutex> lock(pump._mutex);
+					pump._timeout_id = 0;
+					pump._deadlines.erase(pump._deadlines.begin(), pump._deadlines.upper_bound(clock::now()));
+				}
+				pump.poll_views();
+				pump.arm_timeout();
+				return G_SOURCE_REMOVE;
+			}
+
+			void poll_views()
+			{
+				// A poll may close a view (and detach it), so we iterate over
+				// a copy and skip the views that are gone.
+				auto views = _views;
+				for (auto* view : views)
+				{
+					if (std::find(_views.begin(), _views.end(), view) != _views.end())
+						view->poll();
+				}
+			}
+
+			void arm_timeout()
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (_deadlines.empty())
+					return;
+
+				auto next = *_deadlines.begin();
+				if (_timeout_id && _timeout_deadline == next)
+					return;
+				if (_timeout_id)
+					g_source_remove(_timeout_id);
+
+				using ms = std::chrono::duration<double, std::milli>;
+				auto delay = std::max(0.0, std::ceil(ms(next - clock::now()).count()));
+				_timeout_deadline = next;
+				_timeout_id = g_timeout_add(static_cast<guint>(delay), on_timeout, this);
+			}
+
+			int _fd;
+			guint _fd_source_id = 0;
+			std::vector<base_view*> _views;
+
+			// Guards the deadlines and the armed timeout. Deadlines may be
+			// added from any thread; the timeout is only armed by the main loop.
+			std::mutex _mutex;
+			std::multiset<time_point> _deadlines;
+			guint _timeout_id = 0;
+			time_point _timeout_deadline;
+		};
+	}
+
 	static void change_window_cursor(GtkWidget* widget, GdkCursorType type)
 	{
 		GdkDisplay* display = gtk_widget_get_display(widget);
@@ -384,13 +551,6 @@ namespace cycfi::elements
 			base_view.end_focus();
 	}
 
-	int poll_function(gpointer user_data)
-	{
-		auto& base_view = get(user_data);
-		base_view.poll();
-		return true;
-	}
-
 	GtkWidget* make_view(base_view& view, GtkWidget* parent)
 	{
 		auto* content_view = gtk_drawing_area_new();
@@ -459,8 +619,7 @@ namespace cycfi::elements
 						 G_CALLBACK(on_text_entry), &view
 						 );
 
-		// Create 1ms timer
-		g_timeout_add(1, poll_function, &view);
+		io_pump::instance().attach(view);
 
 		return content_view;
 	}
@@ -509,6 +668,9 @@ namespace cycfi::elements
 
 	base_view::~base_view()
 	{
+		io_pump::instance().detach(*this);
+		if (_view->tick_id)
+			gtk_widget_remove_tick_callback(_view->widget, _view->tick_id);
 		if (host_view_under_cursor == _view)
 			host_view_under_cursor = nullptr;
 		delete _view;
@@ -548,12 +710,63 @@ namespace cycfi::elements
 
 	void base_view::refresh(rect area)
 	{
-		gtk_widget_queue_draw_area(_view->widget,
-								   area.left,
-								   area.top,
-								   area.width(),
-								   area.height()
-								   );
+		// Round outwards to whole pixels and add it to the damage that will
+		// be re-rendered into the back buffer at the next draw.
+		auto left = static_cast<int>(std::floor(area.left));
+		auto top = static_cast<int>(std::floor(area.top));
+		auto right = static_cast<int>(std::ceil(area.right));
+		auto bottom = static_cast<int>(std::ceil(area.bottom));
+		if (right <= left || bottom <= top)
+			return;
+
+		cairo_rectangle_int_t r = { left, top, right - left, bottom - top };
+		cairo_region_union_rectangle(_view->damage, &r);
+		gtk_widget_queue_draw_area(_view->widget, r.x, r.y, r.width, r.height);
+	}
+
+	bool base_view::scroll_area(rect area, point offset)
+	{
+		cairo_rectangle_int_t outer;
+		if (!_view->surface
+			|| !scroll_back_buffer(
+				_view->surface, _view->surface_width, _view->surface_height
+			  , _view->damage, area, offset, outer))
+			return false;
+
+		gtk_widget_queue_draw_area(_view->widget, outer.x, outer.y, outer.width, outer.height);
+		return true;
+	}
+
+	void base_view::schedule_poll()
+	{
+		io_pump::instance().wake();
+	}
+
+	void base_view::schedule_poll(std::chrono::steady_clock::time_point deadline)
+	{
+		io_pump::instance().wake(deadline);
+	}
+
+	namespace
+	{
+		gboolean on_tick(GtkWidget* /* widget */, GdkFrameClock* clock, gpointer user_data)
+		{
+			auto& view = *reinterpret_cast<base_view*>(user_data);
+			view.host()->tick_id = 0;
+
+			// The frame clock uses g_get_monotonic_time, which is the same
+			// clock as std::chrono::steady_clock on Linux.
+			auto frame_time = gdk_frame_clock_get_frame_time(clock);
+			view.tick(std::chrono::steady_clock::time_point{ std::chrono::microseconds{ frame_time } });
+			return G_SOURCE_REMOVE;
+		}
+	}
+
+	bool base_view::request_tick()
+	{
+		if (!_view->tick_id)
+			_view->tick_id = gtk_widget_add_tick_callback(_view->widget, on_tick, this, nullptr);
+		return true;
 	}
 
 	std::string clipboard()
@@ -654,6 +654,28 @@ namespace cycfi { namespace elements
       ];
    }
 
+   bool base_view::scroll_area(rect /* area */, point /* offset */)
+   {
+      // Not supported: the view is repainted directly, without a back buffer
+      return false;
+   }
+
+   void base_view::schedule_poll()
+   {
+      // The on_tick timer polls the view
+   }
+
+   void base_view::schedule_poll(std::chrono::steady_clock::time_point /* deadline */)
+   {
+      // The on_tick timer polls the view
+   }
+
+   bool base_view::request_tick()
+   {
+      // No frame clock: the view falls back to a fixed rate timer
+      return false;
+   }
+
    std::string clipboard()
    {
       NSPasteboard* pasteboard = [NSPasteboard generalPasteboard];
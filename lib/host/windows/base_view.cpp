@@ -609,6 +609,28 @@ namespace cycfi { namespace elements
       return get_scale_for_window(_view);
    }
 
+   bool base_view::scroll_area(rect /* area */, point /* offset */)
+   {
+      // Not supported: the view is repainted directly, without a back buffer
+      return false;
+   }
+
+   void base_view::schedule_poll()
+   {
+      // The 1ms timer polls the view
+   }
+
+   void base_view::schedule_poll(std::chrono::steady_clock::time_point /* deadline */)
+   {
+      // The 1ms timer polls the view
+   }
+
+   bool base_view::request_tick()
+   {
+      // No frame clock: the view falls back to a fixed rate timer
+      return false;
+   }
+
    std::string clipboard()
    {
       if (!OpenClipboard(nullptr))
@@ -11,6 +11,8 @@
 
 #if defined(ELEMENTS_HOST_UI_LIBRARY_GTK)
 using GtkApplication = struct _GtkApplication;
+#elif defined(ELEMENTS_HOST_UI_LIBRARY_HEADLESS)
+#include <atomic>
 #endif
 
 namespace cycfi { namespace elements
@@ -40,6 +42,8 @@ namespace cycfi { namespace elements
       GtkApplication* _app;
 #elif defined(ELEMENTS_HOST_UI_LIBRARY_WIN32)
       bool  _running = true;
+#elif defined(ELEMENTS_HOST_UI_LIBRARY_HEADLESS)
+      std::atomic<bool> _running{ true };   // stop may be called from any thread
 #endif
 
       std::string          _app_name;
@@ -11,6 +11,7 @@
 #include <string>
 #include <cstdint>
 #include <functional>
+#include <chrono>
 #include <cairo.h>
 
 #include <infra/support.hpp>
@@ -374,7 +375,8 @@ namespace cycfi::elements
 	// The base view base class
 	////////////////////////////////////////////////////////////////////////////
 
-#if defined(ELEMENTS_HOST_UI_LIBRARY_COCOA) || defined(ELEMENTS_HOST_UI_LIBRARY_GTK)
+#if defined(ELEMENTS_HOST_UI_LIBRARY_COCOA) || defined(ELEMENTS_HOST_UI_LIBRARY_GTK) \
+	|| defined(ELEMENTS_HOST_UI_LIBRARY_HEADLESS)
 	struct host_view;
 	using host_view_handle = host_view*;
 	struct host_window;
@@ -390,7 +392,8 @@ namespace cycfi::elements
 	{
 	public:
 
-#if defined(ELEMENTS_HOST_UI_LIBRARY_COCOA) || defined(ELEMENTS_HOST_UI_LIBRARY_GTK)
+#if defined(ELEMENTS_HOST_UI_LIBRARY_COCOA) || defined(ELEMENTS_HOST_UI_LIBRARY_GTK) \
+	|| defined(ELEMENTS_HOST_UI_LIBRARY_HEADLESS)
 		explicit base_view(host_view_handle h);
 #endif
 		explicit base_view(extent size);
@@ -407,10 +410,27 @@ namespace cycfi::elements
 		virtual void begin_focus() {}
 		virtual void end_focus() {}
 		virtual void poll() {}
+		virtual void tick(std::chrono::steady_clock::time_point /*frame_time*/) {}
 
 		virtual void refresh();
 		virtual void refresh(rect area);
 
+		// Shift the already rendered pixels in area by offset and refresh
+		// only the parts of area that are newly exposed. Returns false if
+		// the host cannot do this, in which case nothing is done.
+		bool scroll_area(rect area, point offset);
+
+		// Ask the host to call poll() as soon as possible, or once the
+		// deadline is reached. Both may be called from any thread.
+		void schedule_poll();
+		void schedule_poll(std::chrono::steady_clock::time_point deadline);
+
+		// Ask the host to call tick() once, at its next frame, with the
+		// time the frame will be presented. Returns false if the host has no
+		// frame clock, in which case tick() is not called. Call from the UI
+		// thread only.
+		bool request_tick();
+
 		[[nodiscard]] float hdpi_scale() const;
 		[[nodiscard]] point cursor_pos() const;
 		[[nodiscard]] extent size() const;
@@ -443,6 +463,31 @@ namespace cycfi::elements
 	////////////////////////////////////////////////////////////////////////////
 	// Scroll direction
 	point scroll_direction();
+
+#if defined(ELEMENTS_HOST_UI_LIBRARY_HEADLESS)
+	////////////////////////////////////////////////////////////////////////////
+	// Headless host
+	//
+	// The headless host renders into a cairo image surface, without a
+	// display. Events are injected through the functions below, which keep
+	// track of the cursor like a real host does before calling the view.
+	// Key and text events can be sent directly using the view's key and
+	// text member functions. Call frame to run the pending posted work and
+	// render what was refreshed.
+	////////////////////////////////////////////////////////////////////////////
+	namespace headless
+	{
+		bool frame(base_view& view);
+		cairo_surface_t* surface(base_view& view);
+		[[nodiscard]] cursor_type current_cursor();
+
+		void mouse_move(base_view& view, point p);
+		void mouse_leave(base_view& view);
+		void click(base_view& view, mouse_button btn);
+		void drag(base_view& view, mouse_button btn);
+		void scroll(base_view& view, point dir, point p);
+	}
+#endif
 }
 
 #endif
@@ -8,6 +8,7 @@
 
 #include <elements/element/align.hpp>
 #include <elements/element/button.hpp>
+#include <elements/element/cache.hpp>
 #include <elements/element/composite.hpp>
 #include <elements/element/dial.hpp>
 #include <elements/element/dynamic_list.hpp>
@@ -16,6 +17,7 @@
 #include <elements/element/grid.hpp>
 #include <elements/element/image.hpp>
 #include <elements/element/indirect.hpp>
+#include <elements/element/keyed.hpp>
 #include <elements/element/label.hpp>
 #include <elements/element/layer.hpp>
 #include <elements/element/margin.hpp>
@@ -25,6 +27,7 @@
 #include <elements/element/port.hpp>
 #include <elements/element/progress_bar.hpp>
 #include <elements/element/proxy.hpp>
+#include <elements/element/record.hpp>
 #include <elements/element/size.hpp>
 #include <elements/element/slider.hpp>
 #include <elements/element/text.hpp>
@@ -0,0 +1,61 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_CACHE_OCTOBER_17_2026)
+#define ELEMENTS_CACHE_OCTOBER_17_2026
+
+#include <elements/element/retained.hpp>
+#include <elements/support/pixmap.hpp>
+#include <infra/support.hpp>
+#include <cstddef>
+#include <memory>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Cached elements
+   //
+   // The subject is rendered into a pixmap, at the device scale and pixel
+   // position it is drawn at, and the pixmap is simply blitted on
+   // subsequent draws. Use this for static subtrees that are expensive to
+   // draw (e.g. panels and decorations).
+   //
+   // The pixmap is discarded as described in retained.hpp, and when the
+   // subject is resized or moved to a different sub-pixel position.
+   ////////////////////////////////////////////////////////////////////////////
+   class cache_element : public retained_element
+   {
+   public:
+
+      struct cache_stats
+      {
+         std::size_t          hits = 0;
+         std::size_t          misses = 0;
+      };
+
+      void                    draw(context const& ctx) override;
+      void                    invalidate() override { _pixmap.reset(); }
+      cache_stats const&      stats() const { return _stats; }
+
+   private:
+
+      void                    render(context const& ctx);
+
+      std::unique_ptr<pixmap> _pixmap;
+      point                   _scale;     // user space to pixels
+      point                   _size;      // the pixmap size, in pixels
+      point                   _phase;     // sub-pixel position of the bounds
+      cache_stats             _stats;
+   };
+
+   template <typename Subject>
+   inline proxy<remove_cvref_t<Subject>, cache_element>
+   cache(Subject&& subject)
+   {
+      return { std::forward<Subject>(subject) };
+   }
+}}
+
+#endif
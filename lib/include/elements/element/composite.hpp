@@ -12,6 +12,7 @@
 
 #include <vector>
 #include <array>
+#include <mutex>
 #include <set>
 
 namespace cycfi { namespace elements
@@ -42,6 +43,12 @@ namespace cycfi { namespace elements
       view_limits             limits(basic_context const& ctx) const override = 0;
       element*                hit_test(context const& ctx, point p) override;
       void                    draw(context const& ctx) override;
+
+      // Safe: the caches are guarded, and derived composites that lay out
+      // lazily while drawing do it through view::exclusive. Derived
+      // composites with other state changed while drawing must override
+      // this.
+      bool                    concurrent_draw() const override { return true; }
       void                    layout(context const& ctx) override = 0;
       void                    refresh(context const& ctx, element& element, int outward = 0) override;
 
@@ -64,28 +71,81 @@ namespace cycfi { namespace elements
       element*                focus() override;
       void                    focus(std::size_t index);
       virtual void            reset();
+      void                    take_state(composite_base const& from, std::size_t from_index, std::size_t index);
+      void                    invalidate_limits() override;
+      composite_base*         as_composite() override { return this; }
 
    // Composite
 
       using weak_element_ptr = std::weak_ptr<elements::element>;
 
+      // element is not owned: it is valid only for as long as the
+      // composite is not modified.
       struct hit_info
       {
-         element_ptr          element;
+         elements::element*   element  = nullptr;
          rect                 bounds   = rect{};
          int                  index    = -1;
       };
 
+      // The range [first, last) of indices of the elements that may be hit
+      struct index_range
+      {
+         std::size_t          first    = 0;
+         std::size_t          last     = 0;
+      };
+
       virtual hit_info        hit_element(context const& ctx, point p, bool control) const;
+      virtual index_range     hit_range(context const& ctx, point p) const;
+
+      // True if the elements' bounds do not overlap (e.g. tiles and grids).
+      // The cursor then stays on the element it last hit, without a search,
+      // as long as that element is still hit.
+      virtual bool            disjoint() const { return false; }
       virtual rect            bounds_of(context const& ctx, std::size_t index) const = 0;
       virtual bool            reverse_index() const { return false; }
 
                               template <typename F>
       void                    for_each(F&& f, bool reverse = false) const;
 
+   protected:
+
+      // Returns the cached limits, or computes them with f() and caches the
+      // result. The cache is discarded by invalidate_limits() or when the
+      // number of elements changes.
+                              template <typename F>
+      view_limits             cached_limits(F&& f) const;
+
    private:
 
       void                    new_focus(context const& ctx, int index);
+      void                    update_wants() const;
+
+      // The caches may be filled while tiles are drawn concurrently (e.g.
+      // the limits asked for by an align element's prepare_subject), so
+      // they are guarded by _cache_mutex. Copies get their own mutex.
+      struct cache_mutex : std::recursive_mutex
+      {
+                              cache_mutex() = default;
+                              cache_mutex(cache_mutex const&) {}
+         cache_mutex&         operator=(cache_mutex const&) { return *this; }
+      };
+
+      using cache_lock = std::lock_guard<std::recursive_mutex>;
+      mutable cache_mutex     _cache_mutex;
+
+      // _limits_owner is set to this when the cache is valid. Copies start
+      // with a stale cache, since the elements are not linked to the copy.
+      mutable view_limits     _limits;
+      mutable std::size_t     _limits_size = 0;
+      mutable void const*     _limits_owner = nullptr;
+
+      // wants_control() and wants_focus() of the elements, cached the same
+      // way as the limits.
+      mutable bool            _wants_control = false;
+      mutable bool            _wants_focus = false;
+      mutable std::size_t     _wants_size = 0;
+      mutable void const*     _wants_owner = nullptr;
 
       int                     _focus = -1;
       int                     _saved_focus = -1;
@@ -169,6 +229,29 @@ namespace cycfi { namespace elements
       return _container.at(_first + ix);
    }
 
+   inline void composite_base::invalidate_limits()
+   {
+      {
+         cache_lock lock(_cache_mutex);
+         _limits_owner = nullptr;
+         _wants_owner = nullptr;
+      }
+      element::invalidate_limits();
+   }
+
+   template <typename F>
+   inline view_limits composite_base::cached_limits(F&& f) const
+   {
+      cache_lock lock(_cache_mutex);
+      if (_limits_owner != this || _limits_size != size())
+      {
+         _limits = f();
+         _limits_size = size();
+         _limits_owner = this;
+      }
+      return _limits;
+   }
+
    template <typename F>
    inline void composite_base::for_each(F&& f, bool reverse) const
    {
@@ -11,13 +11,19 @@
 #include <elements/support/rect.hpp>
 
 #include <infra/string_view.hpp>
+#include <algorithm>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 namespace cycfi::elements
 {
 	struct basic_context;
 	class context;
+	class proxy_base;
+	class composite_base;
+	struct indirect_base;
+	class scrollable;
 
 	////////////////////////////////////////////////////////////////////////////
 	// Elements
@@ -29,6 +35,9 @@ namespace cycfi::elements
 	class element : public std::enable_shared_from_this<element>
 	{
 	public:
+		element() = default;
+		element(const element & rhs);
+		element& operator=(const element & rhs);
 		virtual ~element() = default;
 
 		// Display
@@ -41,6 +50,11 @@ namespace cycfi::elements
 		virtual void refresh(const context & ctx, element& element, int outward /* = 0 */);
 		void refresh(const context & ctx, int outward = 0) { refresh(ctx, *this, outward); }
 
+		// Tiled rendering draws elements from several threads at once. An
+		// element that may be drawn concurrently, from distinct contexts,
+		// returns true; the others are drawn one at a time.
+		virtual bool concurrent_draw() const;
+
 		// Control
 		virtual bool wants_control() const;
 		virtual bool click(const context & ctx, mouse_button btn);
@@ -56,6 +70,41 @@ namespace cycfi::elements
 		virtual const element * focus() const;
 		virtual element* focus();
 
+		// Limits caching
+		//
+		// Composites cache the limits they compute. Call invalidate_limits()
+		// whenever something that affects an element's limits changes; the
+		// cached limits of all its ancestors are discarded. The built-in
+		// setters that change limits already do (e.g. label set_text and
+		// set_font_size, the size element setters such as fixed_size and
+		// hsize, scale, proxy subject and text box set_text). Custom
+		// elements need to do the same in their own setters, and after
+		// modifying a composite's container directly.
+		//
+		// An element is linked to its parent the first time the parent
+		// computes its limits. An element shared by several parents is
+		// linked to all of them: parent() is the first of those that is
+		// still alive, and has_ancestor checks them all.
+		virtual void invalidate_limits();
+		[[nodiscard]] element* parent() const;
+		[[nodiscard]] bool has_ancestor(const element & e) const;
+
+		// A weak reference that expires when this element is destroyed,
+		// for data kept about an element by address (e.g. by the view),
+		// which may be reused by another element.
+		using weak_anchor_ptr = std::weak_ptr<element*>;
+		[[nodiscard]] weak_anchor_ptr anchor() const;
+
+		// Type queries
+		//
+		// Cheap alternatives to dynamic_cast for the types that the
+		// traversal utilities (see traversal.hpp) look for. Each returns
+		// this if the element is of that type, or nullptr.
+		virtual proxy_base* as_proxy();
+		virtual composite_base* as_composite();
+		virtual indirect_base* as_indirect();
+		virtual scrollable* as_scrollable();
+
 		enum class tracking
 		{
 			none,
@@ -66,8 +115,80 @@ namespace cycfi::elements
 
 	protected:
 		void on_tracking(context const& ctx, tracking state);
+		void adopt(const element & child) const;
+
+	private:
+		// The links to the parents go through anchors owned by the parents
+		// so that they expire with the parents, even if the child outlives
+		// them.
+		using anchor_ptr = std::shared_ptr<element*>;
+
+		const anchor_ptr & own_anchor() const;
+
+		mutable anchor_ptr _anchor;
+		mutable std::vector<weak_anchor_ptr> _parents;
 	};
 
+	////////////////////////////////////////////////////////////////////////////
+	// Inlines
+	////////////////////////////////////////////////////////////////////////////
+	inline element::element(const element & rhs)
+		: std::enable_shared_from_this<element>(rhs)
+	{
+		// The copy is not linked to the original's parent or children
+	}
+
+	inline element& element::operator=(const element & /* rhs */)
+	{
+		return *this;
+	}
+
+	inline element* element::parent() const
+	{
+		for (const auto & p : _parents)
+		{
+			if (auto anchor = p.lock())
+				return *anchor;
+		}
+		return nullptr;
+	}
+
+	inline const element::anchor_ptr & element::own_anchor() const
+	{
+		if (!_anchor)
+			_anchor = std::make_shared<element*>(const_cast<element*>(this));
+		return _anchor;
+	}
+
+	inline element::weak_anchor_ptr element::anchor() const
+	{
+		return own_anchor();
+	}
+
+	inline void element::adopt(const element & child) const
+	{
+		own_anchor();
+
+		// Compare owners, not pointers: this is cheap and does not touch the
+		// reference counts.
+		auto& parents = child._parents;
+		auto is_this = [this](const weak_anchor_ptr & p)
+		{
+			return !p.owner_before(_anchor) && !_anchor.owner_before(p);
+		};
+		if (std::find_if(parents.begin(), parents.end(), is_this) != parents.end())
+			return;
+
+		// Drop the links to the parents that are gone before adding this one
+		parents.erase(
+			std::remove_if(parents.begin(), parents.end(),
+				[](const weak_anchor_ptr & p) { return p.expired(); }
+			),
+			parents.end()
+		);
+		parents.push_back(_anchor);
+	}
+
 	////////////////////////////////////////////////////////////////////////////
 	using element_ptr = std::shared_ptr<element>;
 	using element_const_ptr = std::shared_ptr<const element>;
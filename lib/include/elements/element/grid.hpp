@@ -78,6 +78,8 @@ namespace cycfi { namespace elements
       view_limits             limits(basic_context const& ctx) const override;
       void                    layout(context const& ctx) override;
       rect                    bounds_of(context const& ctx, std::size_t index) const override;
+      index_range             hit_range(context const& ctx, point p) const override;
+      bool                    disjoint() const override { return true; }
       std::size_t             num_spans() const override { return _num_spans; }
 
    private:
@@ -127,6 +129,8 @@ namespace cycfi { namespace elements
       view_limits             limits(basic_context const& ctx) const override;
       void                    layout(context const& ctx) override;
       rect                    bounds_of(context const& ctx, std::size_t index) const override;
+      index_range             hit_range(context const& ctx, point p) const override;
+      bool                    disjoint() const override { return true; }
       std::size_t             num_spans() const override { return _num_spans; }
 
    private:
@@ -25,6 +25,7 @@ namespace cycfi { namespace elements
       virtual extent           size() const;
       view_limits             limits(basic_context const& ctx) const override;
       void                    draw(context const& ctx) override;
+      bool                    concurrent_draw() const override { return true; }
       virtual rect            source_rect(context const& ctx) const;
 
    protected:
@@ -50,6 +50,7 @@ namespace cycfi { namespace elements
       unsigned                span() const override;
       element*                hit_test(context const& ctx, point p) override;
       void                    draw(context const& ctx) override;
+      bool                    concurrent_draw() const override;
       void                    layout(context const& ctx) override;
       void                    refresh(context const& ctx, element& element, int outward = 0) override;
 
@@ -76,6 +77,7 @@ namespace cycfi { namespace elements
    {
       virtual element&        get() = 0;
       virtual element const&  get() const = 0;
+      indirect_base*          as_indirect() override { return this; }
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -140,7 +142,9 @@ namespace cycfi { namespace elements
    inline view_limits
    indirect<Base>::limits(basic_context const& ctx) const
    {
-      return this->get().limits(ctx);
+      auto const& e = this->get();
+      this->adopt(e);
+      return e.limits(ctx);
    }
 
    template <typename Base>
@@ -169,6 +173,13 @@ namespace cycfi { namespace elements
       this->get().draw(ctx);
    }
 
+   template <typename Base>
+   inline bool
+   indirect<Base>::concurrent_draw() const
+   {
+      return this->get().concurrent_draw();
+   }
+
    template <typename Base>
    inline void
    indirect<Base>::layout(context const& ctx)
@@ -323,6 +334,7 @@ namespace cycfi { namespace elements
    shared_element<Element>::operator=(std::shared_ptr<Element> ptr)
    {
       _ptr = ptr;
+      this->invalidate_limits();
       return *this;
    }
 
@@ -0,0 +1,149 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_KEYED_OCTOBER_17_2026)
+#define ELEMENTS_KEYED_OCTOBER_17_2026
+
+#include <elements/element/proxy.hpp>
+#include <infra/support.hpp>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Keyed elements
+   //
+   // Tags the subject with a stable key, for reconcile (below). The key
+   // identifies the item the subject presents. If the subject's type has
+   // operator==, keyed() keeps it, so that reconcile can tell if the
+   // subject changed.
+   ////////////////////////////////////////////////////////////////////////////
+   class keyed_element : public proxy_base
+   {
+   public:
+
+      using key_type = std::string;
+      using equal_function = bool(*)(element const& a, element const& b);
+
+                              keyed_element(
+                                 key_type key
+                               , element_ptr subject
+                               , equal_function equal = nullptr
+                              )
+                               : _key(std::move(key))
+                               , _subject(std::move(subject))
+                               , _equal(equal)
+                              {}
+
+      void                    layout(context const& ctx) override;
+
+      element const&          subject() const override;
+      element&                subject() override;
+      key_type const&         key() const { return _key; }
+
+   private:
+
+      friend void             reconcile(
+                                 std::vector<element_ptr> const& current
+                               , std::vector<element_ptr> const& next
+                              );
+
+      key_type                _key;
+      element_ptr             _subject;
+      equal_function          _equal;
+      rect                    _bounds;
+      bool                    _laid_out = false;
+      bool                    _reused = false;
+   };
+
+   namespace detail
+   {
+      template <typename T>
+      struct is_shared_ptr : std::false_type {};
+
+      template <typename T>
+      struct is_shared_ptr<std::shared_ptr<T>> : std::true_type {};
+
+      template <typename T>
+      struct subject_type { using type = T; };
+
+      template <typename T>
+      struct subject_type<std::shared_ptr<T>> { using type = T; };
+
+      template <typename T, typename = void>
+      struct is_equality_comparable : std::false_type {};
+
+      template <typename T>
+      struct is_equality_comparable<T, std::void_t<
+         decltype(bool(std::declval<T const&>() == std::declval<T const&>()))
+      >> : std::true_type {};
+
+      // Only called with subjects of the same dynamic type (see reconcile)
+      template <typename T>
+      inline keyed_element::equal_function equal_function()
+      {
+         if constexpr (is_equality_comparable<T>::value)
+         {
+            return [](element const& a, element const& b)
+            {
+               return bool(static_cast<T const&>(a) == static_cast<T const&>(b));
+            };
+         }
+         else
+         {
+            return nullptr;
+         }
+      }
+   }
+
+   template <typename Subject>
+   inline keyed_element keyed(keyed_element::key_type key, Subject&& subject)
+   {
+      using subject_type = typename detail::subject_type<remove_cvref_t<Subject>>::type;
+      auto equal = detail::equal_function<subject_type>();
+      if constexpr (detail::is_shared_ptr<remove_cvref_t<Subject>>::value)
+         return { std::move(key), std::forward<Subject>(subject), equal };
+      else
+         return { std::move(key), share(std::forward<Subject>(subject)), equal };
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // reconcile: match the keyed elements in the next elements with those
+   // of the same key in the current elements. Where the subjects are the
+   // same, or of the same type and equal (operator==), the current subject
+   // is reused: it keeps its state (focus, hover, cached limits), and its
+   // first layout is skipped if its bounds did not change. Otherwise the
+   // next subject is kept, and is searched for nested keyed elements.
+   //
+   // Either way, the composites the next keyed element is in take over the
+   // focus, tracking and hover state the composites the current one is in
+   // had for it (see composite_base::take_state), from the innermost out.
+   // Each key is matched once.
+   ////////////////////////////////////////////////////////////////////////////
+   void reconcile(
+      std::vector<element_ptr> const& current
+    , std::vector<element_ptr> const& next
+   );
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   inline element const& keyed_element::subject() const
+   {
+      adopt(*_subject);
+      return *_subject;
+   }
+
+   inline element& keyed_element::subject()
+   {
+      adopt(*_subject);
+      return *_subject;
+   }
+}}
+
+#endif
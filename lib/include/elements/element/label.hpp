@@ -30,6 +30,7 @@ namespace cycfi { namespace elements
 
       view_limits             limits(basic_context const& ctx) const override;
       void                    draw(context const& ctx) override;
+      bool                    concurrent_draw() const override { return true; }
 
       virtual font_type       get_font() const;
       virtual float           get_font_size() const;
@@ -49,7 +50,7 @@ namespace cycfi { namespace elements
                               {}
 
       text_type               get_text() const override           { return _text; }
-      void                    set_text(string_view text) override { _text = std::string(text); }
+      void                    set_text(string_view text) override;
 
    private:
 
@@ -67,7 +68,7 @@ namespace cycfi { namespace elements
                               {}
 
       font_type               get_font() const override  { return _font; }
-      void                    set_font(font_type font_)  { _font = font_; }
+      void                    set_font(font_type font_);
 
    private:
 
@@ -84,8 +85,8 @@ namespace cycfi { namespace elements
                               {}
 
       float                   get_font_size() const override      { return _size; }
-      void                    set_font_size(float size)           { _size = size; }
-      void                    set_relative_font_size(float size)  { _size = Base::get_default_font_size() * size; }
+      void                    set_font_size(float size);
+      void                    set_relative_font_size(float size);
 
    private:
 
@@ -173,6 +174,34 @@ namespace cycfi { namespace elements
       return get_theme().label_text_align;
    }
 
+   template <typename Base>
+   inline void basic_label_base<Base>::set_text(string_view text)
+   {
+      _text = std::string(text);
+      this->invalidate_limits();
+   }
+
+   template <typename Base>
+   inline void label_with_font<Base>::set_font(font_type font_)
+   {
+      _font = font_;
+      this->invalidate_limits();
+   }
+
+   template <typename Base>
+   inline void label_with_font_size<Base>::set_font_size(float size)
+   {
+      _size = size;
+      this->invalidate_limits();
+   }
+
+   template <typename Base>
+   inline void label_with_font_size<Base>::set_relative_font_size(float size)
+   {
+      _size = Base::get_default_font_size() * size;
+      this->invalidate_limits();
+   }
+
    template <typename Base>
    inline typename label_gen<Base>::gen_font
    label_gen<Base>::font(font_type font_) const
@@ -105,6 +105,7 @@ namespace cycfi { namespace elements
       using menu_enabled_function = std::function<bool()>;
 
       void                    draw(context const& ctx) override;
+      bool                    concurrent_draw() const override { return false; }
       element*                hit_test(context const& ctx, point p) override;
       bool                    click(context const& ctx, mouse_button btn) override;
       bool                    key(context const& ctx, key_info k) override;
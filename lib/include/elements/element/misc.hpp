@@ -33,6 +33,8 @@ namespace cycfi { namespace elements
          cnv.fill_rect(ctx.bounds);
       }
 
+      bool concurrent_draw() const override { return true; }
+
       color _color;
    };
 
@@ -60,6 +62,8 @@ namespace cycfi { namespace elements
          cnv.fill();
       }
 
+      bool concurrent_draw() const override { return true; }
+
       color _color;
       float _radius;
    };
@@ -153,6 +157,7 @@ namespace cycfi { namespace elements
                      {}
 
       void           draw(context const& ctx) override;
+      bool           concurrent_draw() const override { return true; }
 
    private:
 
@@ -165,6 +170,7 @@ namespace cycfi { namespace elements
    struct frame : public element
    {
       void           draw(context const& ctx) override;
+      bool           concurrent_draw() const override { return true; }
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -175,6 +181,7 @@ namespace cycfi { namespace elements
    public:
 
       void                    draw(context const& ctx) override;
+      bool                    concurrent_draw() const override { return true; }
    };
 
    inline void title_bar::draw(context const& ctx)
@@ -195,6 +202,7 @@ namespace cycfi { namespace elements
                               {}
 
       void                    draw(context const& ctx) override;
+      bool                    concurrent_draw() const override { return true; }
 
    private:
 
@@ -211,6 +219,7 @@ namespace cycfi { namespace elements
 
       view_limits             limits(basic_context const& ctx) const override;
       void                    draw(context const& ctx) override;
+      bool                    concurrent_draw() const override { return true; }
 
       std::uint32_t           _code;
       float                   _size;
@@ -265,6 +274,7 @@ namespace cycfi { namespace elements
 
                               hidable_element(Subject subject);
       void                    draw(context const& ctx) override;
+      bool                    concurrent_draw() const override;
       is_hidden_function      is_hidden = []{ return false; };
    };
 
@@ -280,6 +290,12 @@ namespace cycfi { namespace elements
          this->subject().draw(ctx);
    }
 
+   template <typename Subject>
+   inline bool hidable_element<Subject>::concurrent_draw() const
+   {
+      return this->subject().concurrent_draw();
+   }
+
    template <typename Subject>
    inline hidable_element<remove_cvref_t<Subject>>
    hidable(Subject&& subject)
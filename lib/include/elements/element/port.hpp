@@ -21,6 +21,9 @@ namespace cycfi { namespace elements
 
       void                    draw(context const& ctx) override;
 
+      // Ports lay out their subject as they draw it
+      bool                    concurrent_draw() const override { return false; }
+
       virtual double          halign() const = 0;
       virtual void            halign(double val) = 0;
       virtual double          valign() const = 0;
@@ -121,7 +124,9 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
 
    // scrollable: Mixin class for a element that is scrollable
-   // scroll the rectangle, r into view
+   // scroll the rectangle, r into view. Elements that derive from it must
+   // also override element::as_scrollable(), since that is how find()
+   // finds them: derive from scrollable_element (below), which does.
    class scrollable
    {
    public:
@@ -148,15 +153,31 @@ namespace cycfi { namespace elements
       static scrollable_context  find(context const& ctx);
    };
 
+   // scrollable_element: Base, an element, made scrollable
+   template <typename Base>
+   class scrollable_element : public Base, public scrollable
+   {
+   public:
+
+      using Base::Base;
+
+      scrollable*                as_scrollable() override { return this; }
+   };
+
+   // scroll_blit: scroll by shifting the already rendered pixels and draw
+   // only the newly exposed parts. Use it only if the subject is opaque and
+   // nothing is drawn over the scroller, since those pixels would be shifted
+   // along with the subject's.
    enum
    {
       no_scrollbars  = 1,
       no_hscroll     = 1 << 1,
-      no_vscroll     = 1 << 2
+      no_vscroll     = 1 << 2,
+      scroll_blit    = 1 << 3
    };
 
    // Base proxy class for views that are scrollable
-   class scroller_base : public port_element, public scrollable
+   class scroller_base : public scrollable_element<port_element>
    {
    public:
 
@@ -212,6 +233,7 @@ namespace cycfi { namespace elements
 
       scrollbar_bounds  get_scrollbar_bounds(context const& ctx);
       bool              reposition(context const& ctx, point p);
+      void              scroll_to(context const& ctx, double halign_, double valign_);
 
       bool              has_scrollbars() const { return !(_traits & no_scrollbars); }
       bool              allow_hscroll() const { return !(_traits & no_hscroll); }
@@ -220,6 +242,7 @@ namespace cycfi { namespace elements
       point             _offset;
       tracking_status   _tracking;
       int               _traits;
+      point             _drawn_size;
    };
 
    template <typename Subject>
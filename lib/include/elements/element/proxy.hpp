@@ -28,6 +28,7 @@ namespace cycfi::elements
 		unsigned span() const override;
 		element* hit_test(context const& ctx, point p) override;
 		void draw(const context & ctx) override;
+		bool concurrent_draw() const override { return true; }
 		void layout(const context & ctx) override;
 		void refresh(const context & ctx, element& element, int outward /* = 0 */) override;
 		virtual void prepare_subject(context& ctx);
@@ -54,6 +55,7 @@ namespace cycfi::elements
 		// Proxy
 		virtual const element & subject() const = 0;
 		virtual element& subject() = 0;
+		proxy_base* as_proxy() override { return this; }
 	};
 
 	template <typename Subject, typename Base = proxy_base>
@@ -67,31 +69,47 @@ namespace cycfi::elements
 		        "Subject must not be a reference type - maybe you want to use reference class instead");
 		static_assert(!std::is_const_v<Subject>, "Subject must not be const");
 
+		// The subject is adopted once, when the proxy is constructed. Copies
+		// adopt their own subject. Assigning a new subject keeps the link:
+		// it is the same element.
 		template <typename... T>
 		// need implicit conversions
 		proxy(Subject subject_, T&&... args)
-			: Base(std::forward<T>(args)...), _subject(std::move(subject_)) {}
+			: Base(std::forward<T>(args)...), _subject(std::move(subject_))
+		{
+			this->adopt(_subject);
+		}
 
-		void subject(Subject&& subject)
+		proxy(const proxy & rhs)
+			: Base(rhs), _subject(rhs._subject)
 		{
-			_subject = std::move(subject);
+			this->adopt(_subject);
 		}
 
-		void subject(const Subject & subject)
+		proxy(proxy&& rhs)
+			: Base(std::move(rhs)), _subject(std::move(rhs._subject))
 		{
-			_subject = subject;
+			this->adopt(_subject);
 		}
 
-		[[nodiscard]] const element& subject() const override
+		proxy& operator=(const proxy & rhs) = default;
+		proxy& operator=(proxy&& rhs) = default;
+
+		void subject(Subject&& subject)
 		{
-			return _subject;
+			_subject = std::move(subject);
+			this->invalidate_limits();
 		}
 
-		[[nodiscard]] element& subject() override
+		void subject(const Subject & subject)
 		{
-			return _subject;
+			_subject = subject;
+			this->invalidate_limits();
 		}
 
+		[[nodiscard]] const element& subject() const override { return _subject; }
+		[[nodiscard]] element& subject() override { return _subject; }
+
 	private:
 		Subject _subject;
 	};
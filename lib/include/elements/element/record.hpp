@@ -0,0 +1,68 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_RECORD_OCTOBER_17_2026)
+#define ELEMENTS_RECORD_OCTOBER_17_2026
+
+#include <elements/element/retained.hpp>
+#include <infra/support.hpp>
+#include <cairo.h>
+#include <cstddef>
+#include <memory>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Recorded elements
+   //
+   // The subject is drawn once into a display list (a cairo recording
+   // surface) that holds the canvas operations it issued: paths, fills,
+   // strokes, glyphs, images and state changes. Subsequent draws replay the
+   // display list, translated to where the subject is drawn, without
+   // traversing the subject. Unlike cache (see cache.hpp), the display list
+   // keeps vector quality at any scale or transform.
+   //
+   // The display list is discarded as described in retained.hpp, and when
+   // the subject is resized.
+   ////////////////////////////////////////////////////////////////////////////
+   class record_element : public retained_element
+   {
+   public:
+
+      struct record_stats
+      {
+         std::size_t          hits = 0;
+         std::size_t          misses = 0;
+      };
+
+      void                    draw(context const& ctx) override;
+      void                    invalidate() override { _recording.reset(); }
+      record_stats const&     stats() const { return _stats; }
+
+   private:
+
+      struct surface_deleter
+      {
+         void operator()(cairo_surface_t* s) const { cairo_surface_destroy(s); }
+      };
+
+      using surface_ptr = std::unique_ptr<cairo_surface_t, surface_deleter>;
+
+      void                    record(context const& ctx);
+
+      surface_ptr             _recording;
+      rect                    _bounds;    // the bounds the subject was recorded at
+      record_stats            _stats;
+   };
+
+   template <typename Subject>
+   inline proxy<remove_cvref_t<Subject>, record_element>
+   record(Subject&& subject)
+   {
+      return { std::forward<Subject>(subject) };
+   }
+}}
+
+#endif
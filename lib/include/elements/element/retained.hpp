@@ -0,0 +1,37 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_RETAINED_OCTOBER_17_2026)
+#define ELEMENTS_RETAINED_OCTOBER_17_2026
+
+#include <elements/element/proxy.hpp>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Retained elements
+   //
+   // Base of the proxies that keep what their subject drew, and draw that
+   // instead of the subject (see cache.hpp and record.hpp). What is kept is
+   // discarded by invalidate(): when invalidate_limits() is called, or when
+   // an element inside the subject is refreshed through
+   // view::refresh(element) or view::refresh(ctx). Handling an event does
+   // not discard it: elements that change how they look refresh.
+   ////////////////////////////////////////////////////////////////////////////
+   class retained_element : public proxy_base
+   {
+   public:
+
+      bool                    concurrent_draw() const override { return false; }
+      void                    refresh(context const& ctx, element& element, int outward = 0) override;
+      void                    invalidate_limits() override;
+
+      using element::refresh;
+
+      virtual void            invalidate() = 0;
+   };
+}}
+
+#endif
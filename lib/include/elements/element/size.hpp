@@ -28,7 +28,7 @@ namespace cycfi { namespace elements
       view_limits             limits(basic_context const& ctx) const override;
       void                    prepare_subject(context& ctx) override;
 
-      void                    fixed_size(extent size) { _size = size; }
+      void                    fixed_size(extent size) { _size = size; this->invalidate_limits(); }
       extent                  fixed_size() const { return _size; }
 
    private:
@@ -80,7 +80,7 @@ namespace cycfi { namespace elements
       view_limits             limits(basic_context const& ctx) const override;
       void                    prepare_subject(context& ctx) override;
 
-      void                    hsize(float width) { _width = width; }
+      void                    hsize(float width) { _width = width; this->invalidate_limits(); }
       float                   hsize() const { return _width; }
 
    private:
@@ -129,7 +129,7 @@ namespace cycfi { namespace elements
       view_limits             limits(basic_context const& ctx) const override;
       void                    prepare_subject(context& ctx) override;
 
-      void                    vsize(float height) { _height = height; }
+      void                    vsize(float height) { _height = height; this->invalidate_limits(); }
       float                   vsize() const { return _height; }
 
    private:
@@ -180,7 +180,7 @@ namespace cycfi { namespace elements
       view_limits             limits(basic_context const& ctx) const override;
       void                    prepare_subject(context& ctx) override;
 
-      void                    min_size(point size) { _size = size; }
+      void                    min_size(point size) { _size = size; this->invalidate_limits(); }
       point                   min_size() const { return _size; }
 
    private:
@@ -234,7 +234,7 @@ namespace cycfi { namespace elements
       view_limits             limits(basic_context const& ctx) const override;
       void                    prepare_subject(context& ctx) override;
 
-      void                    hmin_size(float width) { _width = width; }
+      void                    hmin_size(float width) { _width = width; this->invalidate_limits(); }
       float                   hmin_size() const { return _width; }
 
    private:
@@ -284,7 +284,7 @@ namespace cycfi { namespace elements
       view_limits             limits(basic_context const& ctx) const override;
       void                    prepare_subject(context& ctx) override;
 
-      void                    vmin_size(float height) { _height = height; }
+      void                    vmin_size(float height) { _height = height; this->invalidate_limits(); }
       float                   vmin_size() const { return _height; }
 
    private:
@@ -336,7 +336,7 @@ namespace cycfi { namespace elements
       view_limits             limits(basic_context const& ctx) const override;
       void                    prepare_subject(context& ctx) override;
 
-      void                    max_size(point size) { _size = size; }
+      void                    max_size(point size) { _size = size; this->invalidate_limits(); }
       point                   max_size() const { return _size; }
 
    private:
@@ -390,7 +390,7 @@ namespace cycfi { namespace elements
       view_limits             limits(basic_context const& ctx) const override;
       void                    prepare_subject(context& ctx) override;
 
-      void                    hmax_size(float size) { _size = size; }
+      void                    hmax_size(float size) { _size = size; this->invalidate_limits(); }
       float                   hmax_size() const { return _size; }
 
    private:
@@ -534,7 +534,7 @@ namespace cycfi { namespace elements
                               span_element(unsigned span, Subject subject);
 
       unsigned                span() const override   { return _span; }
-      void                    span(float span)        { _span = span; }
+      void                    span(float span)        { _span = span; this->invalidate_limits(); }
 
    private:
 
@@ -571,7 +571,7 @@ namespace cycfi { namespace elements
 
       view_limits             limits(basic_context const& ctx) const override;
 
-      void                    limit(view_limits limits) { _limits = limits; }
+      void                    limit(view_limits limits) { _limits = limits; this->invalidate_limits(); }
       view_limits             limit() const { return _limits; }
 
    private:
@@ -619,7 +619,7 @@ namespace cycfi { namespace elements
       void                    prepare_subject(context& ctx, point& p) override;
       void                    restore_subject(context& ctx) override;
 
-      void                    scale(float scale_) { _scale = scale_; }
+      void                    scale(float scale_) { _scale = scale_; this->invalidate_limits(); }
       float                   scale() const { return _scale; }
 
    private:
@@ -7,10 +7,14 @@
 #define ELEMENTS_TEXT_APRIL_17_2016
 
 #include <elements/support/glyphs.hpp>
+#include <elements/support/piece_table.hpp>
 #include <elements/support/theme.hpp>
 #include <elements/element/element.hpp>
 
 #include <infra/string_view.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -59,23 +63,61 @@ namespace cycfi { namespace elements
       void                    layout(context const& ctx) override;
       void                    draw(context const& ctx) override;
 
-      std::string const&      get_text() const override            { return _text; }
+      std::string const&      get_text() const override            { return _text.str(); }
       void                    set_text(string_view text) override;
 
-      std::string const&      value() const override           { return _text; }
+      std::string const&      value() const override           { return _text.str(); }
       void                    value(string_view val) override;
 
+   protected:
+
+      // The text is laid out a paragraph (the text between newlines) at a
+      // time. An edit reshapes and rewraps only the paragraphs it touches,
+      // and layout refreshes only their rows. The paragraphs do not copy
+      // their text: they view it in _text (see piece_table::contiguous),
+      // which keeps it in place when the box is moved.
+      struct paragraph
+      {
+                              paragraph(string_view text_, master_glyphs const& source);
+
+         string_view          text;             // the text, without the newline
+         master_glyphs        layout;
+         std::vector<glyphs>  rows;             // empty if there is no text
+         std::size_t          offset = 0;       // where the text starts in _text
+         float                y = 0;            // the top of the first row
+
+         std::size_t          num_rows() const  { return std::max<std::size_t>(rows.size(), 1); }
+      };
+
+      using paragraph_ptr = std::unique_ptr<paragraph>;
+      using paragraph_list = std::vector<paragraph_ptr>;
+
+      void                    replace(std::size_t pos, std::size_t count, string_view text);
+      void                    mark_dirty(std::size_t pos, std::size_t end);
+      std::size_t             paragraph_at(std::size_t pos) const;
+      std::size_t             paragraph_at_y(float y) const;
+      float                   line_height() const;
+      float                   height() const;
+
    private:
 
-      void                    sync() const;
+      void                    reshape(
+                                 std::size_t first, std::size_t last
+                               , std::size_t start, std::size_t end
+                              );
+      void                    wrap(paragraph& p, float width);
+      void                    update_positions(std::size_t first);
+      void                    compact();
 
    protected:
 
-      std::string             _text;
-      mutable master_glyphs   _layout;
-      std::vector<glyphs>     _rows;
+      piece_table             _text;            // get_text() is its contiguous view
+      master_glyphs           _layout;          // the font; the text is shaped per paragraph
+      paragraph_list          _paragraphs;
       color                   _color;
       point                   _current_size = { -1, -1 };
+      float                   _dirty_top = -1;  // the rows to refresh on the next layout
+      float                   _dirty_bottom = -1;
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -122,7 +164,8 @@ namespace cycfi { namespace elements
 
    protected:
 
-      void                    scroll_into_view(context const& ctx, bool save_x);
+      void                    scroll_into_view(context const& ctx, bool save_x, bool refresh = true);
+      void                    edit(int pos, int count, string_view text);
       virtual void            delete_(bool forward);
       virtual void            cut(view& v, int start, int end);
       virtual void            copy(view& v, int start, int end);
@@ -132,27 +175,42 @@ namespace cycfi { namespace elements
 
       struct glyph_metrics
       {
-         char const* str;           // The start of the utf8 string
+         int         index;         // Where the glyph is in the text, or -1
          point       pos;           // Position where glyph is drawn
          rect        bounds;        // Glyph bounds
          float       line_height;   // Line height
       };
 
-      char const*             caret_position(context const& ctx, point p);
-      glyph_metrics           glyph_info(context const& ctx, char const* s);
+      int                     caret_position(context const& ctx, point p);
+      glyph_metrics           glyph_info(context const& ctx, int index);
+
+      // Moving through the text. The newline between paragraphs is a
+      // single byte, and is not in the paragraphs' text.
+      int                     next_index(int index) const;
+      int                     prev_index(int index) const;
+      char const*             utf8_at(int index) const;
 
-      struct state_saver;
-      using state_saver_f = std::function<void()>;
+      // Undo and redo replay the edits: edit() records what it replaced,
+      // and add_undo() adds it to the view's undo history. Typing at the
+      // end of the last typed text extends it instead. set_text() makes
+      // the recorded edits stale: they no longer apply to the text.
+      struct edit_record;
+      using edit_record_ptr = std::shared_ptr<edit_record>;
 
-      state_saver_f           capture_state();
+      void                    add_undo(view& v);
+      void                    clear_stale_undo(view& v);
+      void                    mark_selection_dirty();
 
       int                     _select_start;
       int                     _select_end;
       float                   _current_x;
-      state_saver_f           _typing_state;
+      edit_record_ptr         _edit;            // not yet in the undo history
+      edit_record_ptr         _typing;          // the typing run being extended
+      std::uint32_t           _generation;      // incremented by set_text
       bool                    _is_focus : 1;
       bool                    _show_caret : 1;
       bool                    _caret_started : 1;
+      bool                    _undo_stale : 1;  // the view has stale edits of ours
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -164,7 +222,10 @@ namespace cycfi { namespace elements
 
       using basic_text_box::get_text;
 
-      using text_function = std::function<void(string_view text)>;
+      // The text is given as a view of the text box's text, so that it is
+      // not flattened on each keystroke. Functions that take a string_view
+      // still work, but flatten it.
+      using text_function = std::function<void(text_view text)>;
 
                               basic_input_box(
                                  std::string placeholder = ""
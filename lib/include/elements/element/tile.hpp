@@ -22,6 +22,8 @@ namespace cycfi { namespace elements
       void                    draw(context const& ctx) override;
       void                    layout(context const& ctx) override;
       rect                    bounds_of(context const& ctx, std::size_t index) const override;
+      index_range             hit_range(context const& ctx, point p) const override;
+      bool                    disjoint() const override { return true; }
 
    private:
 
@@ -51,6 +53,8 @@ namespace cycfi { namespace elements
       void                    draw(context const& ctx) override;
       void                    layout(context const& ctx) override;
       rect                    bounds_of(context const& ctx, std::size_t index) const override;
+      index_range             hit_range(context const& ctx, point p) const override;
+      bool                    disjoint() const override { return true; }
 
    private:
 
@@ -13,15 +13,37 @@
 
 namespace cycfi { namespace elements
 {
+   ////////////////////////////////////////////////////////////////////////////
+   // element_cast: dynamic_cast<Ptr>(e), using the element's type queries
+   // (e.g. element::as_proxy()) instead of RTTI where there is one for the
+   // type. Scrollable elements are found by as_scrollable() only (see
+   // scrollable_element).
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename Ptr>
+   inline Ptr element_cast(element* e)
+   {
+      using type = std::remove_cv_t<std::remove_pointer_t<Ptr>>;
+      if constexpr (std::is_same_v<type, proxy_base>)
+         return e->as_proxy();
+      else if constexpr (std::is_same_v<type, composite_base>)
+         return e->as_composite();
+      else if constexpr (std::is_same_v<type, indirect_base>)
+         return e->as_indirect();
+      else if constexpr (std::is_same_v<type, scrollable>)
+         return e->as_scrollable();
+      else
+         return dynamic_cast<Ptr>(e);
+   }
+
    namespace detail
    {
       template <typename Ptr>
       inline Ptr find_element_impl(element* e_)
       {
-         if (auto* e = dynamic_cast<Ptr>(e_))
+         if (auto* e = element_cast<Ptr>(e_))
             return e;
 
-         if (auto* e = dynamic_cast<indirect_base*>(e_))
+         if (auto* e = e_->as_indirect())
             return find_element_impl<Ptr>(&e->get());
 
          return nullptr;
@@ -35,13 +57,13 @@ namespace cycfi { namespace elements
    template <typename Ptr>
    inline Ptr find_subject(element* e_)
    {
-      proxy_base* proxy = dynamic_cast<proxy_base*>(e_);
+      proxy_base* proxy = e_->as_proxy();
       while (proxy)
       {
          auto* subject = &proxy->subject();
          if (auto* e = detail::find_element_impl<Ptr>(subject))
             return e;
-         proxy = dynamic_cast<proxy_base*>(subject);
+         proxy = subject->as_proxy();
       }
       return nullptr;
    }
@@ -75,7 +97,7 @@ namespace cycfi { namespace elements
          auto&& find =
             [&](context const& ctx, element* e) -> bool
             {
-               if (auto c = dynamic_cast<composite_base*>(e); c && c != this_)
+               if (auto c = e->as_composite(); c && c != this_)
                {
                   result.first = c;
                   result.second = &ctx;
@@ -88,13 +110,13 @@ namespace cycfi { namespace elements
          if (find(*p, e))
             return result;
 
-         proxy_base* proxy = dynamic_cast<proxy_base*>(e);
+         proxy_base* proxy = e->as_proxy();
          while (proxy)
          {
             auto* subject = &proxy->subject();
             if (find(*p, subject))
                return result;
-            proxy = dynamic_cast<proxy_base*>(subject);
+            proxy = subject->as_proxy();
          }
          p = p->parent;
       }
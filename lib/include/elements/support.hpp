@@ -15,10 +15,12 @@
 #include <elements/support/font.hpp>
 #include <elements/support/glyphs.hpp>
 #include <elements/support/icon_ids.hpp>
+#include <elements/support/piece_table.hpp>
 #include <elements/support/pixmap.hpp>
 #include <elements/support/point.hpp>
 #include <elements/support/rect.hpp>
 #include <elements/support/draw_utils.hpp>
+#include <elements/support/text_cache.hpp>
 #include <elements/support/text_utils.hpp>
 #include <elements/support/theme.hpp>
 
@@ -0,0 +1,56 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_DAMAGE_REGION_OCTOBER_17_2026)
+#define ELEMENTS_DAMAGE_REGION_OCTOBER_17_2026
+
+#include <elements/support/rect.hpp>
+#include <cairo.h>
+#include <cstddef>
+
+namespace cycfi::elements
+{
+	////////////////////////////////////////////////////////////////////////////
+	// damage_region: the union of the areas that need to be redrawn, rounded
+	// outward to whole device units. To keep the cost of drawing and of
+	// adding to the region bounded, the region collapses to its bounding box
+	// once it has more than max_rects rectangles.
+	////////////////////////////////////////////////////////////////////////////
+	class damage_region
+	{
+	public:
+		static constexpr std::size_t default_max_rects = 16;
+
+		explicit damage_region(std::size_t max_rects = default_max_rects);
+		damage_region(const damage_region & rhs);
+		damage_region& operator=(const damage_region & rhs);
+		~damage_region();
+
+		void add(const rect & r);
+		void add(const damage_region & other);
+		void clear();
+		void swap(damage_region & other);
+
+		[[nodiscard]] bool empty() const;
+		[[nodiscard]] std::size_t size() const;
+		[[nodiscard]] rect operator[](std::size_t i) const;
+		[[nodiscard]] rect extents() const;
+		[[nodiscard]] float area() const;
+		[[nodiscard]] bool intersects(const rect & r) const;
+
+		std::size_t max_rects() const { return _max_rects; }
+		void max_rects(std::size_t n);
+
+		cairo_region_t* cairo_region() const { return _region; }
+
+	private:
+		void limit();
+
+		cairo_region_t* _region;
+		std::size_t _max_rects;
+	};
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_FRAME_HISTOGRAM_OCTOBER_17_2026)
+#define ELEMENTS_FRAME_HISTOGRAM_OCTOBER_17_2026
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace cycfi::elements
+{
+	////////////////////////////////////////////////////////////////////////////
+	// frame_histogram: durations of the last `window` frames, bucketed in
+	// powers of two microseconds. Bucket 0 holds everything below 2us, bucket
+	// i holds [2^i, 2^(i+1)) us and the last bucket holds everything above.
+	////////////////////////////////////////////////////////////////////////////
+	class frame_histogram
+	{
+	public:
+		using duration = std::chrono::steady_clock::duration;
+
+		static constexpr std::size_t window = 128;
+		static constexpr std::size_t num_buckets = 16;
+
+		void add(duration d);
+
+		std::size_t size() const { return _size; }
+		std::size_t count(std::size_t bucket) const { return _buckets[bucket]; }
+		static duration bucket_limit(std::size_t bucket);
+
+		duration mean() const;
+		duration max() const;
+		duration percentile(double p) const;
+
+	private:
+		static std::size_t bucket_of(duration d);
+
+		std::array<duration, window> _samples = {};
+		std::array<std::size_t, num_buckets> _buckets = {};
+		std::size_t _size = 0;
+		std::size_t _next = 0;
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	// Inlines
+	////////////////////////////////////////////////////////////////////////////
+	inline std::size_t frame_histogram::bucket_of(duration d)
+	{
+		auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+		std::size_t bucket = 0;
+		while (us > 1 && bucket < num_buckets-1)
+		{
+			us >>= 1;
+			++bucket;
+		}
+		return bucket;
+	}
+
+	inline frame_histogram::duration frame_histogram::bucket_limit(std::size_t bucket)
+	{
+		if (bucket >= num_buckets-1)
+			return duration::max();
+		return std::chrono::microseconds(std::int64_t(2) << bucket);
+	}
+
+	inline void frame_histogram::add(duration d)
+	{
+		if (_size == window)
+			--_buckets[bucket_of(_samples[_next])];
+		else
+			++_size;
+		_samples[_next] = d;
+		++_buckets[bucket_of(d)];
+		_next = (_next + 1) % window;
+	}
+
+	inline frame_histogram::duration frame_histogram::mean() const
+	{
+		if (_size == 0)
+			return duration::zero();
+		duration total = duration::zero();
+		for (std::size_t i = 0; i != _size; ++i)
+			total += _samples[i];
+		return total / _size;
+	}
+
+	inline frame_histogram::duration frame_histogram::max() const
+	{
+		if (_size == 0)
+			return duration::zero();
+		return *std::max_element(_samples.begin(), _samples.begin() + _size);
+	}
+
+	inline frame_histogram::duration frame_histogram::percentile(double p) const
+	{
+		if (_size == 0)
+			return duration::zero();
+		auto samples = _samples;
+		auto n = std::min(static_cast<std::size_t>(p * _size), _size - 1);
+		std::nth_element(samples.begin(), samples.begin() + n, samples.begin() + _size);
+		return samples[n];
+	}
+}
+
+#endif
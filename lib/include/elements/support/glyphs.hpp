@@ -11,6 +11,7 @@
 #include <elements/support/canvas.hpp>
 #include <elements/support/text_utils.hpp>
 #include <cairo.h>
+#include <algorithm>
 #include <vector>
 #include <stdexcept>
 #include <string>
@@ -41,10 +42,27 @@ namespace cycfi { namespace elements
                            template <typename F>
       void                 for_each(F f);
 
+      // The bounds of a cluster, relative to the start of the glyphs, and
+      // where it starts in the text. utf8 is nullptr if there is no such
+      // cluster.
+      struct cluster_bounds
+      {
+         char const*       utf8 = nullptr;
+         float             left = 0;
+         float             right = 0;
+      };
+
+      cluster_bounds       cluster_at(float x) const;
+      cluster_bounds       cluster_from(char const* s) const;
+
       std::size_t          size() const      { return _last - _first; }
       char const*          begin() const     { return _first; }
       char const*          end() const       { return _last; }
 
+      // Point the glyphs to a copy of their text, starting at first. The
+      // text is not shaped again.
+      void                 rebase(char const* first);
+
       struct font_metrics
       {
          float             ascent;
@@ -62,6 +80,18 @@ namespace cycfi { namespace elements
       using cluster = cairo_text_cluster_t;
       using cluster_flags = cairo_text_cluster_flags_t;
 
+      // Computed once by master_glyphs::build: where each cluster starts
+      // and ends (the x of its first glyph, plus that glyph's advance), and
+      // its offset in the master's text.
+      struct cluster_info
+      {
+         float             left;
+         float             right;
+         int               byte;
+      };
+
+      cluster_bounds       bounds_of(cluster_info const& info) const;
+
       char const*          _first;
       char const*          _last;
       scaled_font*         _scaled_font   = nullptr;
@@ -70,6 +100,8 @@ namespace cycfi { namespace elements
       cluster*             _clusters      = nullptr;
       int                  _cluster_count = 0;
       cluster_flags        _clusterflags;
+      float const*         _advances      = nullptr;
+      cluster_info const*  _cluster_info  = nullptr;
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -133,6 +165,9 @@ namespace cycfi { namespace elements
       master_glyphs&       operator=(master_glyphs const& rhs) = delete;
 
       void                 build(point start = { 0, 0 });
+
+      std::vector<float>         _advance_data;
+      std::vector<cluster_info>  _cluster_data;
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -188,26 +223,62 @@ namespace cycfi { namespace elements
       if (_first == _last)
          return;
 
-      int   glyph_index = 0;
-      int   byte_index = 0;
-      float start_x = _glyphs->x;
-
       for (int i = 0; i < _cluster_count; i++)
       {
-         cairo_text_cluster_t* cluster = _clusters + i;
-         cairo_glyph_t* glyph = _glyphs + glyph_index;
-         cairo_text_extents_t extents;
-         cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
-
-         float x = glyph->x - start_x;
-         if (!f(_first + byte_index, x, x + extents.x_advance))
+         auto b = bounds_of(_cluster_info[i]);
+         if (!f(b.utf8, b.left, b.right))
             break;
-
-         // glyph/byte position
-         glyph_index += cluster->num_glyphs;
-         byte_index += cluster->num_bytes;
       }
    }
+
+   inline void glyphs::rebase(char const* first)
+   {
+      _last = first + (_last - _first);
+      _first = first;
+   }
+
+   inline glyphs::cluster_bounds glyphs::bounds_of(cluster_info const& info) const
+   {
+      float start_x = _glyphs->x;
+      return {
+         _first + (info.byte - _cluster_info->byte)
+       , info.left - start_x
+       , info.right - start_x
+      };
+   }
+
+   inline glyphs::cluster_bounds glyphs::cluster_at(float x) const
+   {
+      if (_first == _last || _cluster_count == 0)
+         return {};
+
+      // The clusters are ordered by their left edge
+      float target = x + _glyphs->x;
+      auto first = _cluster_info;
+      auto last = _cluster_info + _cluster_count;
+      auto i = std::upper_bound(first, last, target,
+         [](float x, cluster_info const& c) { return x < c.left; }
+      );
+      if (i == first || !(target < (i-1)->right))
+         return {};
+      return bounds_of(*(i-1));
+   }
+
+   inline glyphs::cluster_bounds glyphs::cluster_from(char const* s) const
+   {
+      if (_first == _last || _cluster_count == 0)
+         return {};
+
+      int target = int(s - _first) + _cluster_info->byte;
+      auto first = _cluster_info;
+      auto last = _cluster_info + _cluster_count;
+      auto i = std::lower_bound(first, last, target,
+         [](cluster_info const& c, int byte) { return c.byte < byte; }
+      );
+      if (i == last)
+         return {};
+      return bounds_of(*i);
+   }
 }}
 
 #endif
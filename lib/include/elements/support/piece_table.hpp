@@ -0,0 +1,173 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_PIECE_TABLE_OCTOBER_17_2026)
+#define ELEMENTS_PIECE_TABLE_OCTOBER_17_2026
+
+#include <infra/string_view.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cycfi::elements
+{
+	////////////////////////////////////////////////////////////////////////////
+	// piece_table: text storage for editing. The text is a sequence of
+	// pieces, each a span of one of the buffers: the original text, which is
+	// never modified, and the added text, which is only appended to, in
+	// chunks. The buffers are on the heap and are never moved, not even when
+	// the piece_table is. Edits split and join pieces and never move the text
+	// itself.
+	//
+	// The pieces are kept in a balanced tree (a treap) ordered by position,
+	// with the size of the text of each subtree, so that finding a position,
+	// inserting and erasing take O(log n) in the number of pieces (plus the
+	// size of the inserted text). Typing at the same place extends the last
+	// piece instead of adding one.
+	//
+	// contiguous() makes a range of the text a single piece, copying it to
+	// the added text if it is not one already, and returns a view of it. The
+	// view stays valid across edits and moves of the piece_table until the
+	// next assign() or compact(). The copies leave garbage behind: the
+	// bytes in the buffers that are no longer in the text. compact() moves
+	// the text to a new original buffer, leaving none.
+	//
+	// str() is the contiguous view of the whole text, for the APIs that need
+	// a std::string. It is built when asked for and kept until the next edit.
+	////////////////////////////////////////////////////////////////////////////
+	class piece_table
+	{
+	public:
+		piece_table() = default;
+		explicit piece_table(std::string text);
+
+		piece_table(piece_table&&) = default;
+		piece_table& operator=(piece_table&&) = default;
+
+		piece_table(const piece_table &) = delete;
+		piece_table& operator=(const piece_table &) = delete;
+
+		std::size_t size() const { return size_of(_root); }
+		bool empty() const { return !_root; }
+
+		char operator[](std::size_t pos) const;
+		std::string substr(std::size_t pos, std::size_t n) const;
+		const std::string & str() const;
+
+		// F signature: void f(string_view piece)
+		template <typename F>
+		void for_each_piece(F f) const { for_each_piece(_root.get(), f); }
+
+		void assign(string_view text);
+		void insert(std::size_t pos, string_view text);
+		void erase(std::size_t pos, std::size_t n);
+		void replace(std::size_t pos, std::size_t n, string_view text);
+
+		string_view contiguous(std::size_t pos, std::size_t n);
+		std::size_t garbage() const { return _stored - size(); }
+		void compact();
+
+	private:
+		struct piece
+		{
+			std::uint32_t buffer;   // 0 for the original, else _added[buffer-1]
+			std::size_t start;
+			std::size_t length;
+		};
+
+		struct node;
+		using node_ptr = std::unique_ptr<node>;
+
+		struct node
+		{
+			piece p;
+			std::uint32_t priority;
+			std::size_t size;       // the size of the text of this subtree
+			node_ptr left;
+			node_ptr right;
+		};
+
+		struct chunk
+		{
+			std::unique_ptr<char[]> data;
+			std::size_t size = 0;
+			std::size_t capacity = 0;
+		};
+
+		static constexpr std::size_t min_chunk_size = 16 * 1024;
+
+		static chunk make_chunk(std::size_t capacity);
+		static std::size_t size_of(const node_ptr & t) { return t? t->size : 0; }
+		static void update(node& t);
+		static node_ptr merge(node_ptr l, node_ptr r);
+
+		template <typename F>
+		void for_each_piece(const node* t, F& f) const;
+
+		void reset(chunk original);
+		node_ptr make_node(piece p);
+		piece add(string_view text);
+		void split(node_ptr t, std::size_t pos, node_ptr& l, node_ptr& r);
+		bool extend(node* t, string_view text);
+		void append_to(std::string& out, const node* t, std::size_t pos, std::size_t end) const;
+		string_view text_of(const piece & p) const;
+
+		chunk _original;
+		std::vector<chunk> _added;
+		std::size_t _stored = 0;    // the size of the original and added text
+		node_ptr _root;
+		std::uint32_t _seed = 2463534242;
+
+		mutable std::string _flat;
+		mutable bool _flat_valid = true;
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	// text_view: a read-only view of the text of a piece_table, given to
+	// change notifications. Reading it a piece, a character or a range at a
+	// time does not flatten the text; converting it to a string_view does,
+	// the first time after an edit (see piece_table::str()).
+	////////////////////////////////////////////////////////////////////////////
+	class text_view
+	{
+	public:
+		explicit text_view(const piece_table & text) : _text(&text) {}
+
+		std::size_t size() const { return _text->size(); }
+		bool empty() const { return _text->empty(); }
+
+		char operator[](std::size_t pos) const { return (*_text)[pos]; }
+		std::string substr(std::size_t pos, std::size_t n) const { return _text->substr(pos, n); }
+		std::string str() const { return _text->str(); }
+		operator string_view() const { return _text->str(); }
+
+		// F signature: void f(string_view piece)
+		template <typename F>
+		void for_each_piece(F f) const { _text->for_each_piece(f); }
+
+	private:
+		const piece_table* _text;
+	};
+
+	bool operator==(text_view a, string_view b);
+	inline bool operator!=(text_view a, string_view b) { return !(a == b); }
+
+	////////////////////////////////////////////////////////////////////////////
+	// Implementation
+	////////////////////////////////////////////////////////////////////////////
+	template <typename F>
+	inline void piece_table::for_each_piece(const node* t, F& f) const
+	{
+		if (!t)
+			return;
+		for_each_piece(t->left.get(), f);
+		f(text_of(t->p));
+		for_each_piece(t->right.get(), f);
+	}
+}
+
+#endif
@@ -8,6 +8,7 @@
 
 #include <vector>
 #include <memory>
+#include <utility>
 #include <cairo.h>
 #include <elements/support/point.hpp>
 #include <stdexcept>
@@ -53,7 +54,10 @@ namespace cycfi::elements
 				return *this;
 			}
 
+			if (surface)
+				cairo_surface_destroy(surface);
 			surface = std::exchange(rhs.surface, nullptr);
+			return *this;
 		}
 
 		~pixmap()
@@ -99,6 +103,18 @@ namespace cycfi::elements
 
 	using pixmap_ptr = std::shared_ptr<pixmap>;
 
+	template<typename T, typename>
+	inline pixmap::pixmap(size_type width, size_type height, T scale)
+		: surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height))
+	{
+		if (!surface)
+			throw failed_to_load_pixmap{ "Failed to create pixmap." };
+
+		// Set scale and flag the surface as dirty
+		cairo_surface_set_device_scale(surface, static_cast<double>(1)/scale, static_cast<double>(1)/scale);
+		cairo_surface_mark_dirty(surface);
+	}
+
 	////////////////////////////////////////////////////////////////////////////
 	// pixmap_context allows drawing into a pixmap
 	////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,103 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_TEXT_CACHE_OCTOBER_17_2026)
+#define ELEMENTS_TEXT_CACHE_OCTOBER_17_2026
+
+#include <infra/string_view.hpp>
+#include <cairo.h>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cycfi::elements
+{
+	////////////////////////////////////////////////////////////////////////////
+	// text_cache: a bounded LRU cache of shaped text. An entry holds the
+	// glyph run of a UTF-8 string, positioned from the origin, with its text
+	// extents and the font extents. Entries are keyed by the scaled font
+	// (the font face, size and transform) and the text.
+	//
+	// The canvas text functions (fill_text, stroke_text and measure_text)
+	// go through the process-wide cache, get().
+	////////////////////////////////////////////////////////////////////////////
+	class text_cache
+	{
+	public:
+		struct entry
+		{
+			std::vector<cairo_glyph_t> glyphs;
+			cairo_text_extents_t extents = {};
+			cairo_font_extents_t font_extents = {};
+		};
+
+		struct cache_stats
+		{
+			std::size_t hits = 0;
+			std::size_t misses = 0;
+
+			float hit_rate() const
+			{
+				auto total = hits + misses;
+				return total? float(hits) / total : 0.0f;
+			}
+		};
+
+		using entry_ptr = std::shared_ptr<const entry>;
+
+		static constexpr std::size_t default_capacity = 1024;
+
+		explicit text_cache(std::size_t capacity = default_capacity);
+		~text_cache();
+
+		text_cache(const text_cache &) = delete;
+		text_cache& operator=(const text_cache &) = delete;
+
+		static text_cache& get();
+
+		// The shaped text for the context's current scaled font
+		entry_ptr find(cairo_t& context, const char * utf8);
+
+		cache_stats stats() const;
+		void reset_stats();
+		void clear();
+
+		std::size_t capacity() const;
+		void capacity(std::size_t n);
+
+	private:
+		using key_type = std::pair<cairo_scaled_font_t*, string_view>;
+
+		struct key_hash
+		{
+			std::size_t operator()(const key_type & key) const;
+		};
+
+		struct node
+		{
+			cairo_scaled_font_t* font;
+			std::string text;
+			entry_ptr shaped;
+		};
+
+		using node_list = std::list<node>;
+		using node_map = std::unordered_map<key_type, node_list::iterator, key_hash>;
+
+		void evict(std::size_t n);
+
+		mutable std::mutex _mutex;
+		node_list _nodes;       // most recently used first
+		node_map _map;          // keys point into the nodes
+		std::size_t _capacity;
+		cache_stats _stats;
+	};
+}
+
+#endif
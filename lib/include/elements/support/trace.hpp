@@ -0,0 +1,111 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_TRACE_OCTOBER_17_2026)
+#define ELEMENTS_TRACE_OCTOBER_17_2026
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <typeinfo>
+
+namespace cycfi::elements::trace
+{
+	////////////////////////////////////////////////////////////////////////////
+	// Trace zones
+	//
+	// A zone measures the time from its construction to its destruction and
+	// records it into a ring buffer owned by the calling thread. Recording
+	// does not lock or allocate (except for the first event of each thread).
+	// Only the last ring_size events of each thread are kept. dump() writes
+	// them in the Chrome trace_event JSON format (load it in chrome://tracing
+	// or ui.perfetto.dev). It may run while the threads record: the events
+	// they overwrite while it reads are left out.
+	//
+	// Zones are compiled in only if ELEMENTS_TRACE is defined (see the
+	// ELEMENTS_ENABLE_TRACE CMake option); otherwise the ELEMENTS_TRACE_ZONE
+	// macros expand to nothing. When compiled in, recording can still be
+	// switched on and off at run time with enable().
+	//
+	// Names and categories are not copied: they must be string literals.
+	// Zones may also be named after a type (e.g. the element being drawn),
+	// which dump() demangles.
+	////////////////////////////////////////////////////////////////////////////
+	using clock = std::chrono::steady_clock;
+
+	struct event
+	{
+		const char* name;
+		const char* category;
+		std::int64_t begin;     // nanoseconds since the trace epoch
+		std::int64_t end;
+		bool type_name;
+	};
+
+	constexpr std::size_t ring_size = 8192;
+
+	namespace detail
+	{
+		extern std::atomic<bool> enabled;
+	}
+
+	void enable(bool enable_ = true);
+	void clear();
+	void dump(std::ostream& out);
+	void record(const event & ev);
+	std::int64_t now();
+
+	inline bool enabled()
+	{
+		return detail::enabled.load(std::memory_order_relaxed);
+	}
+
+	class zone
+	{
+	public:
+		zone(const char* category, const char* name)
+			: _name(name)
+			, _category(category)
+			, _begin(enabled()? now() : -1)
+		{}
+
+		zone(const char* category, const std::type_info & type)
+			: _name(type.name())
+			, _category(category)
+			, _begin(enabled()? now() : -1)
+			, _type_name(true)
+		{}
+
+		~zone()
+		{
+			if (_begin >= 0)
+				record({ _name, _category, _begin, now(), _type_name });
+		}
+
+		zone(const zone &) = delete;
+		zone& operator=(const zone &) = delete;
+
+	private:
+		const char* _name;
+		const char* _category;
+		std::int64_t _begin;
+		bool _type_name = false;
+	};
+}
+
+#define ELEMENTS_TRACE_CAT_(a, b) a##b
+#define ELEMENTS_TRACE_CAT(a, b) ELEMENTS_TRACE_CAT_(a, b)
+
+#if defined(ELEMENTS_TRACE)
+# define ELEMENTS_TRACE_ZONE(category, name)                                  \
+   ::cycfi::elements::trace::zone                                             \
+      ELEMENTS_TRACE_CAT(elements_trace_zone_, __LINE__){ category, name }
+#else
+# define ELEMENTS_TRACE_ZONE(category, name)
+#endif
+
+#endif
@@ -10,14 +10,24 @@
 #include <elements/support/rect.hpp>
 #include <elements/support/canvas.hpp>
 #include <elements/support/theme.hpp>
+#include <elements/support/detail/scratch_context.hpp>
+#include <elements/support/damage_region.hpp>
+#include <elements/support/frame_histogram.hpp>
+#include <elements/support/trace.hpp>
 #include <elements/element/element.hpp>
 #include <elements/element/layer.hpp>
 #include <elements/element/size.hpp>
 #include <elements/element/indirect.hpp>
+#include <elements/element/keyed.hpp>
 #include <asio.hpp>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <deque>
 
 namespace cycfi { namespace elements
 {
@@ -53,19 +63,46 @@ namespace cycfi { namespace elements
       void                    refresh(rect area) override;
       void                    refresh(element& element, int outward = 0);
       void                    refresh(context const& ctx, int outward = 0);
+      void                    scroll_refresh(context const& ctx, point offset);
       rect                    dirty() const;
 
+      // Refreshes from any thread are accumulated and handed to the host
+      // at once, before the next frame. damage() is what was refreshed
+      // for the frame being drawn, in device coordinates. The host may
+      // draw more than that (e.g. when the window is exposed); dirty()
+      // is the bounding box of what is drawn.
+      damage_region const&    damage() const       { return _draw_damage; }
+      void                    max_damage_rects(std::size_t n);
+
+      // The undo and redo histories are limited by the memory their tasks
+      // hold: size, plus the task itself. Adding a task drops the oldest
+      // ones beyond undo_limit(), except the newest.
+      //
+      // add_undo returns an id for the task. While it is the newest undo
+      // task (nothing was added, undone or redone since), grow_undo adds
+      // to its size, for tasks that are extended in place (e.g. typing).
+      // clear_undo removes the tasks of an owner from both histories.
       struct undo_redo_task
       {
          std::function<void()> undo;
          std::function<void()> redo;
+         std::size_t          size = 0;   // memory held by undo and redo
+         void const*          owner = nullptr;
       };
 
-      void                    add_undo(undo_redo_task t);
+      using undo_id = std::uint64_t;
+      static constexpr std::size_t default_undo_limit = 16 * 1024 * 1024;
+
+      undo_id                 add_undo(undo_redo_task t);
+      bool                    grow_undo(undo_id id, std::size_t bytes);
+      void                    clear_undo(void const* owner);
       bool                    has_undo();
       bool                    has_redo();
       bool                    undo();
       bool                    redo();
+      std::size_t             undo_limit() const   { return _undo_limit; }
+      void                    undo_limit(std::size_t bytes);
+      std::size_t             undo_memory() const  { return _undo_memory; }
 
       using content_type = layer_composite;
       using layers_type = layer_composite::container_type;
@@ -74,6 +111,8 @@ namespace cycfi { namespace elements
       scaled_content&         main_element()         { return _main_element; }
       scaled_content const&   main_element() const   { return _main_element; }
 
+      // Call content().invalidate_limits() after modifying the content
+      // directly, unless only the number of layers changed.
       content_type&           content();
       content_type const&     content() const;
       void                    content(std::initializer_list<element_ptr> list);
@@ -81,6 +120,15 @@ namespace cycfi { namespace elements
                               template <typename... E>
       void                    content(E&&... elements);
 
+      // Replace the content, reconciling the keyed elements (see keyed.hpp)
+      // with those in the current content: unchanged subjects are reused,
+      // and the focus and hover state follows the keys. Like add and
+      // remove, this is deferred.
+      void                    reconcile(std::initializer_list<element_ptr> list);
+
+                              template <typename... E>
+      void                    reconcile(E&&... elements);
+
       void                    add(element_ptr e);
       void                    remove(element_ptr e);
       bool                    is_open(element_ptr e);
@@ -91,6 +139,8 @@ namespace cycfi { namespace elements
       using change_limits_function = std::function<void(view_limits limits_)>;
       change_limits_function on_change_limits;
 
+      // Work posted directly to io() is only serviced at the next poll;
+      // use post(), which also wakes the host.
       using io_context = asio::io_context;
       io_context&             io();
 
@@ -100,6 +150,16 @@ namespace cycfi { namespace elements
                               template <typename F>
       void                    post(F f);
 
+      // Call f once, at the next frame, with the time the frame will be
+      // presented. All the callbacks requested for a frame are called
+      // together, aligned with the display's frame clock where the host
+      // has one, or at a fixed rate otherwise. May be called from any
+      // thread. Request again from the callback to animate.
+      using frame_time = std::chrono::steady_clock::time_point;
+      using frame_callback = std::function<void(frame_time time)>;
+      void                    request_frame(frame_callback f);
+      void                    tick(frame_time time) override;
+
       using tracking = element::tracking;
 
       using track_function = std::function<void(element& e, tracking state)>;
@@ -107,6 +167,79 @@ namespace cycfi { namespace elements
 
       void                    manage_on_tracking(element& e, tracking state);
 
+      // Drags and cursor movements are coalesced: only the latest one is
+      // dispatched, at most once per frame. While dispatching, the motion
+      // history holds the positions received since the previous dispatch,
+      // the last being the current position (e.g. for drawing tools).
+      // Set raw_motion to dispatch every movement as it is received.
+      std::vector<point> const& motion_history() const   { return _motion_history; }
+      bool                    raw_motion() const         { return _raw_motion; }
+      void                    raw_motion(bool raw);
+
+      // Statistics of the last drawn frame. Times are measured in draw();
+      // the element counts are those of the children and subjects visited
+      // by composites and proxies while drawing.
+      struct frame_stats
+      {
+         using duration = std::chrono::steady_clock::duration;
+
+         duration             limits_time = {};
+         duration             layout_time = {};
+         duration             draw_time = {};
+         std::size_t          visited = 0;
+         std::size_t          drawn = 0;
+         std::size_t          culled = 0;
+         float                damaged_area = 0;    // in pixels
+         std::size_t          pending_posts = 0;
+      };
+
+      // Rolling histograms of the last frame_histogram::window frames
+      struct frame_history
+      {
+         frame_histogram      limits_time;
+         frame_histogram      layout_time;
+         frame_histogram      draw_time;
+         frame_histogram      total_time;
+      };
+
+      frame_stats const&      last_frame() const      { return _frame; }
+      frame_history const&    frame_times() const     { return _frame_history; }
+
+      using frame_function = std::function<void(frame_stats const& stats)>;
+      frame_function          on_frame;
+
+      // Used by elements while drawing to report what they draw and cull
+      void                    count_drawn(std::size_t drawn, std::size_t culled);
+      void                    note_drawn(context const& ctx);
+
+      // Used by composites while dispatching the cursor: note_hit records
+      // the child the cursor is sent to, from the outermost composite in,
+      // and still_hit tells if e, a child hit by the last dispatch, is
+      // still hit at p, by hit testing only the innermost element of the
+      // last hit path below it (see composite_base::cursor). Elements that
+      // move their content (e.g. scrollers) call forget_hit_path, since
+      // the cursor then maps to other elements.
+      void                    note_hit(element& e, rect bounds, point p);
+      bool                    still_hit(context const& ctx, element& e, rect bounds, point p);
+      void                    forget_hit_path()       { _last_hit_depth = 0; }
+
+      // Tiled rendering (opt-in). With n > 1, large damaged areas are split
+      // into bands that n threads draw into separate image surfaces, which
+      // are then composited. Elements whose concurrent_draw() is false are
+      // not drawn by the threads: they are drawn on the view's thread after
+      // the bands are composited, along with the elements drawn after them
+      // that overlap them, to keep the drawing order. Their contexts have
+      // no parent.
+      void                    draw_threads(std::size_t n);
+      std::size_t             draw_threads() const    { return _draw_threads; }
+
+      // Used by composites and proxies to draw their children, and by
+      // elements for work that must not run concurrently while drawing
+      // (e.g. lazy layout).
+      void                    draw_child(element& e, context const& ctx);
+                              template <typename F>
+      void                    exclusive(F&& f);
+
    private:
 
       scaled_content          make_scaled_content() { return elements::scale(1.0, link(_content)); }
@@ -115,6 +248,23 @@ namespace cycfi { namespace elements
       scaled_content          _main_element;
 
       void                    set_limits();
+      void                    flush_damage();
+      void                    reconcile_content(std::vector<element_ptr> next);
+      void                    schedule_frame();
+      bool                    draw_tiles(cairo_t* context_, rect subj_bounds);
+      void                    queue_motion(bool drag, mouse_button btn);
+      void                    flush_motion();
+      void                    dispatch_drag(mouse_button btn);
+      void                    dispatch_cursor(point p, cursor_tracking status);
+      rect const*             drawn_bounds(element const& e, int outward) const;
+
+                              template <typename F>
+      void                    call(F f);
+
+      // Limits computation and event dispatch measure against this
+      // persistent canvas instead of creating a cairo context each time.
+      detail::scratch_context _scratch;
+      canvas                  _measure{ *_scratch.context() };
 
       rect                    _dirty;
       rect                    _current_bounds;
@@ -122,9 +272,15 @@ namespace cycfi { namespace elements
       mouse_button            _current_button;
       bool                    _is_focus = false;
 
-      using undo_stack_type = std::stack<undo_redo_task>;
-      undo_stack_type         _undo_stack;
+      using undo_stack_type = std::deque<undo_redo_task>;
+      undo_stack_type         _undo_stack;         // the newest at the back
       undo_stack_type         _redo_stack;
+      std::size_t             _undo_memory = 0;
+      std::size_t             _undo_limit = default_undo_limit;
+      undo_id                 _last_undo_id = 0;
+      undo_id                 _newest_undo_id = 0; // 0 if it is not the one added last
+
+      void                    trim_undo();
 
       io_context              _io;
       io_context::work        _work;
@@ -133,6 +289,114 @@ namespace cycfi { namespace elements
       element*                _tracking_element = nullptr;
       tracking                _tracking_state = tracking::none;
       time_point              _tracking_time;
+      time_point              _tracking_deadline;  // when poll() is scheduled to check the tracking
+
+      // The elements the cursor was sent to, from the outermost in, with
+      // their bounds and the cursor position each was given. The entries
+      // are overwritten in place as the dispatch goes down the tree, so
+      // that while dispatching, the entries from _hit_depth up to
+      // _last_hit_depth are still the ones of the last dispatch. The
+      // anchors are only copied when the element at a level changes.
+      struct hit_entry
+      {
+         element*             e = nullptr;
+         element::weak_anchor_ptr anchor;
+         rect                 bounds;
+         point                p;
+      };
+
+      std::vector<hit_entry>  _hit_path;
+      std::size_t             _hit_depth = 0;
+      std::size_t             _last_hit_depth = 0;
+      bool                    _dispatching_cursor = false;
+
+      frame_stats             _frame;
+      frame_history           _frame_history;
+      std::atomic<std::size_t> _pending_posts{ 0 };
+
+      // Where each element was last drawn, in device coordinates, so that
+      // refreshing an element does not have to search the element tree.
+      // Elements drawn more than once in a frame (shared elements) are
+      // marked shared and are refreshed by searching the tree. Entries
+      // whose anchor expired are for destroyed elements, and are ignored:
+      // the address may be reused. The map is cleared by layout, since
+      // the elements may move.
+      struct drawn_info
+      {
+         rect                 bounds;
+         std::uint64_t        frame = 0;
+         bool                 shared = false;
+         element::weak_anchor_ptr anchor;
+      };
+
+      using drawn_map = std::unordered_map<element const*, drawn_info>;
+      using pending_refresh = std::pair<element*, int>;
+
+      drawn_map               _drawn;
+      std::uint64_t           _draw_count = 0;
+
+      // An element left for the view's thread while drawing tiles: its
+      // bounds, the transform from its user space to the view's pixels,
+      // and the clip in its user space (if it is made of rectangles).
+      struct deferred_draw
+      {
+         element*             e = nullptr;
+         rect                 bounds;
+         rect                 device_bounds;
+         cairo_matrix_t       matrix;
+         std::vector<rect>    clip;
+         bool                 clipped = false;
+      };
+
+      // What is drawn on each thread is collected in a draw_scope, and
+      // merged into _frame and _drawn at the end of the frame.
+      struct draw_scope
+      {
+         canvas const*        cnv = nullptr;
+         point                pixel_origin = { 0, 0 };   // of a band, in the view's pixels
+         point                scale = { 1, 1 };          // from pixels to the view's device space
+         std::size_t          drawn = 0;
+         std::size_t          culled = 0;
+         std::vector<std::pair<element const*, rect>> elements;
+         std::vector<deferred_draw> deferred;
+      };
+
+      void                    merge(draw_scope const& scope);
+      static rect             device_bounds(context const& ctx, draw_scope const& scope);
+      void                    defer(element& e, context const& ctx, draw_scope& scope);
+      void                    draw_deferred(cairo_t* context_, std::vector<draw_scope*> const& scopes, double dsx, double dsy);
+      static thread_local draw_scope* current_scope;
+
+      struct draw_workers;
+      std::unique_ptr<draw_workers> _workers;
+      std::size_t             _draw_threads = 1;
+      bool                    _drawing_tiles = false;
+      std::recursive_mutex    _draw_mutex;
+
+      std::mutex              _request_mutex;
+      std::vector<pending_refresh> _pending_refresh;
+      damage_region           _damage;
+      bool                    _damage_all = false;
+      bool                    _flush_posted = false;
+
+      damage_region           _frame_damage;
+      damage_region           _draw_damage;
+
+      // Frame callbacks. Hosts without a frame clock use _frame_timer,
+      // firing at frame_period.
+      static constexpr auto   frame_period = std::chrono::microseconds(1000000 / 60);
+      std::vector<frame_callback> _frame_callbacks;
+      asio::steady_timer      _frame_timer{ _io };
+      bool                    _frame_timer_set = false;
+      frame_time              _last_tick;
+
+      // Pending pointer motion
+      bool                    _raw_motion = false;
+      bool                    _motion_pending = false;
+      bool                    _motion_is_drag = false;
+      bool                    _motion_frame_requested = false;
+      mouse_button            _motion;
+      std::vector<point>      _motion_history;
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -178,6 +442,7 @@ namespace cycfi { namespace elements
    {
       _content = list;
       std::reverse(_content.begin(), _content.end());
+      _content.invalidate_limits();
       set_limits();
    }
 
@@ -201,9 +466,21 @@ namespace cycfi { namespace elements
    {
       _content = { detail::add_element(std::forward<E>(elements))... };
       std::reverse(_content.begin(), _content.end());
+      _content.invalidate_limits();
       set_limits();
    }
 
+   inline void view::reconcile(std::initializer_list<element_ptr> list)
+   {
+      reconcile_content(list);
+   }
+
+   template <typename... E>
+   inline void view::reconcile(E&&... elements)
+   {
+      reconcile_content({ detail::add_element(std::forward<E>(elements))... });
+   }
+
    inline void view::add(element_ptr e)
    {
       // We'll defer this call just to be safe, to give the trigger that
@@ -214,11 +491,12 @@ namespace cycfi { namespace elements
             || std::find(_content.begin(), _content.end(), e) != _content.end())
             return;
 
-         io().post(
+         post(
             [e, this]
             {
                end_focus();
                _content.push_back(e);
+               _content.invalidate_limits();
                layout(*e);
                begin_focus();
             }
@@ -234,7 +512,7 @@ namespace cycfi { namespace elements
       // post a function that is called at idle time.
       if (e)
       {
-         io().post(
+         post(
             [e, this]
             {
                auto i = std::find(_content.begin(), _content.end(), e);
@@ -243,6 +521,7 @@ namespace cycfi { namespace elements
                   end_focus();
                   refresh(*e);
                   _content.erase(i);
+                  _content.invalidate_limits();
                   _content.reset();
                   layout();
                   begin_focus();
@@ -273,6 +552,20 @@ namespace cycfi { namespace elements
       return _current_button;
    }
 
+   template <typename F>
+   inline void view::exclusive(F&& f)
+   {
+      if (_drawing_tiles)
+      {
+         std::lock_guard<std::recursive_mutex> lock(_draw_mutex);
+         f();
+      }
+      else
+      {
+         f();
+      }
+   }
+
    template <typename T, typename F>
    inline void view::post(T duration, F f)
    {
@@ -282,15 +575,28 @@ namespace cycfi { namespace elements
          [timer, f](auto const& err)
          {
             if (!err)
+            {
+               ELEMENTS_TRACE_ZONE("io", "view::post");
                f();
+            }
          }
       );
+      schedule_poll(timer->expiry());
    }
 
    template <typename F>
    inline void view::post(F f)
    {
-      _io.post(f);
+      ++_pending_posts;
+      _io.post(
+         [this, f]() mutable
+         {
+            --_pending_posts;
+            ELEMENTS_TRACE_ZONE("io", "view::post");
+            f();
+         }
+      );
+      schedule_poll();
    }
 }}
 
@@ -0,0 +1,91 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/element/cache.hpp>
+#include <elements/support/canvas.hpp>
+#include <elements/support/context.hpp>
+#include <elements/view.hpp>
+#include <cmath>
+
+namespace cycfi { namespace elements
+{
+   void cache_element::draw(context const& ctx)
+   {
+      auto& cr = ctx.canvas.cairo_context();
+
+      // The transform from user space to pixels: the canvas matrix followed
+      // by the device scale of the target surface (e.g. hi-dpi windows).
+      cairo_matrix_t m;
+      cairo_get_matrix(&cr, &m);
+      double dsx, dsy;
+      cairo_surface_get_device_scale(cairo_get_target(&cr), &dsx, &dsy);
+
+      // Only plain scaling and translation can be cached
+      if (m.xy != 0 || m.yx != 0 || m.xx <= 0 || m.yy <= 0)
+      {
+         _pixmap.reset();
+         proxy_base::draw(ctx);
+         return;
+      }
+
+      point scale = { float(m.xx * dsx), float(m.yy * dsy) };
+      point tl = {
+         float((ctx.bounds.left * m.xx + m.x0) * dsx)
+       , float((ctx.bounds.top * m.yy + m.y0) * dsy)
+      };
+      point br = {
+         float((ctx.bounds.right * m.xx + m.x0) * dsx)
+       , float((ctx.bounds.bottom * m.yy + m.y0) * dsy)
+      };
+
+      // The pixmap covers whole pixels. The sub-pixel position of the
+      // bounds is rendered into the pixmap, so that it can be blitted 1:1.
+      point pixel_pos = { std::floor(tl.x), std::floor(tl.y) };
+      point size = { std::ceil(br.x) - pixel_pos.x, std::ceil(br.y) - pixel_pos.y };
+      point phase = { tl.x - pixel_pos.x, tl.y - pixel_pos.y };
+      if (size.x < 1 || size.y < 1)
+         return;
+
+      if (!_pixmap || _scale != scale || _size != size || _phase != phase)
+      {
+         ++_stats.misses;
+         _scale = scale;
+         _size = size;
+         _phase = phase;
+         render(ctx);
+      }
+      else
+      {
+         ++_stats.hits;
+      }
+
+      // Blit in pixel space
+      auto state = ctx.canvas.new_state();
+      cairo_identity_matrix(&cr);
+      ctx.canvas.scale(1.0 / dsx, 1.0 / dsy);
+      ctx.canvas.draw(*_pixmap, pixel_pos);
+   }
+
+   void cache_element::render(context const& ctx)
+   {
+      _pixmap = std::make_unique<pixmap>(int(_size.x), int(_size.y), 1.0f);
+
+      pixmap_context pm_ctx{ *_pixmap };
+      canvas pm_cnv{ *pm_ctx.context() };
+
+      // Map the subject's bounds to the pixmap, at the same scale and
+      // sub-pixel position it would have been drawn at.
+      pm_cnv.translate(_phase);
+      pm_cnv.scale(_scale);
+      pm_cnv.translate(-ctx.bounds.left, -ctx.bounds.top);
+
+      context sctx{ ctx.view, pm_cnv, &subject(), ctx.bounds };
+      sctx.parent = &ctx;
+      prepare_subject(sctx);
+      subject().draw(sctx);
+      restore_subject(sctx);
+      cairo_surface_flush(cairo_get_target(pm_ctx.context()));
+   }
+}}
@@ -17,22 +17,31 @@ namespace cycfi { namespace elements
       if (!empty())
       {
          hit_info info = hit_element(ctx, p, false);
-         return info.element.get();
+         return info.element;
       }
       return nullptr;
    }
 
    void composite_base::draw(context const& ctx)
    {
+      // Draw only the elements that intersect the clip extent. The canvas
+      // is clipped to the dirty region of the view, so a partial refresh
+      // only draws what it damaged.
+      auto clip_extent = ctx.canvas.clip_extent();
+      std::size_t drawn = 0;
       for (std::size_t ix = 0; ix < size(); ++ix)
       {
-         if (auto bounds = bounds_of(ctx, ix); bounds.is_intersects(ctx.view_bounds()))
+         if (auto bounds = bounds_of(ctx, ix); bounds.is_intersects(clip_extent))
          {
             auto& e = at(ix);
             context ectx{ ctx, &e, bounds };
-            e.draw(ectx);
+            ELEMENTS_TRACE_ZONE("draw", typeid(e));
+            ctx.view.draw_child(e, ectx);
+            ctx.view.note_drawn(ectx);
+            ++drawn;
          }
       }
+      ctx.view.count_drawn(drawn, size() - drawn);
    }
 
    void composite_base::refresh(context const& ctx, element& element, int outward)
@@ -65,7 +74,10 @@ namespace cycfi { namespace elements
                if (wants_focus() && _focus != info.index)
                   new_focus(ctx, info.index);
 
-               context ectx{ ctx, info.element.get(), info.bounds };
+               // Keep the element alive: the click may remove it
+               auto pin = info.element->shared_from_this();
+               context ectx{ ctx, info.element, info.bounds };
+               ELEMENTS_TRACE_ZONE("event", typeid(*info.element));
                if (info.element->click(ectx, btn))
                {
                   if (btn.down)
@@ -79,6 +91,7 @@ namespace cycfi { namespace elements
             rect  bounds = bounds_of(ctx, _click_tracking);
             auto& e = at(_click_tracking);
             context ectx{ ctx, &e, bounds };
+            ELEMENTS_TRACE_ZONE("event", typeid(e));
             if (e.click(ectx, btn))
                return true;
          }
@@ -123,6 +136,7 @@ namespace cycfi { namespace elements
          rect bounds = bounds_of(ctx, ix);
          auto& e = at(ix);
          context ectx{ ctx, &e, bounds };
+         ELEMENTS_TRACE_ZONE("event", typeid(e));
          return e.key(ectx, k);
       };
 
@@ -214,6 +228,7 @@ namespace cycfi { namespace elements
             {
                auto& e = at(ix);
                context ectx{ ctx, &e, bounds_of(ctx, ix) };
+               ELEMENTS_TRACE_ZONE("event", typeid(e));
                e.cursor(ectx, p, cursor_tracking::leaving);
             }
          }
@@ -222,6 +237,7 @@ namespace cycfi { namespace elements
 
       // Send cursor leaving to all currently hovering elements if p is
       // outside the elements's bounds or if the element is no longer hit.
+      hit_info tracked;
       for (auto i = _cursor_hovering.begin(); i != _cursor_hovering.end();)
       {
          if (*i < int(size()))
@@ -229,19 +245,31 @@ namespace cycfi { namespace elements
             auto& e = at(*i);
             rect  b = bounds_of(ctx, *i);
             context ectx{ ctx, &e, b };
-            if (!b.includes(p) || !e.hit_test(ectx, p))
+
+            // The tracking element is usually still hit: if it is, the view
+            // can tell by hit testing only the innermost element it was
+            // sent to by the last dispatch, instead of the whole subtree.
+            bool hit = b.includes(p) && (
+                  (*i == _cursor_tracking && ctx.view.still_hit(ctx, e, b, p))
+               || e.hit_test(ectx, p)
+            );
+            if (!hit)
             {
+               ELEMENTS_TRACE_ZONE("event", typeid(e));
                e.cursor(ectx, p, cursor_tracking::leaving);
                i = _cursor_hovering.erase(i);
                continue;
             }
+            if (*i == _cursor_tracking)
+               tracked = hit_info{ &e, b, *i };
          }
          ++i;
       }
 
       // Send cursor entering to newly hit element or hovering to current
-      // tracking element
-      hit_info info = hit_element(ctx, p, true);
+      // tracking element. If the elements do not overlap, the tracking
+      // element, if still hit, is the one that would be found.
+      hit_info info = (tracked.element && disjoint())? tracked : hit_element(ctx, p, true);
       if (info.element)
       {
          _cursor_tracking = info.index;
@@ -251,9 +279,10 @@ namespace cycfi { namespace elements
             status = cursor_tracking::entering;
             _cursor_hovering.insert(_cursor_tracking);
          }
-         auto& e = at(_cursor_tracking);
-         context ectx{ ctx, &e, bounds_of(ctx, _cursor_tracking) };
-         return e.cursor(ectx, p, status);
+         context ectx{ ctx, info.element, info.bounds };
+         ctx.view.note_hit(*info.element, info.bounds, p);
+         ELEMENTS_TRACE_ZONE("event", typeid(*info.element));
+         return info.element->cursor(ectx, p, status);
       }
 
       return false;
@@ -266,19 +295,37 @@ namespace cycfi { namespace elements
          hit_info info = hit_element(ctx, p, true);
          if (auto ptr = info.element; ptr && info.bounds.is_intersects(ctx.view_bounds()))
          {
-            context ectx{ ctx, ptr.get(), info.bounds };
+            auto pin = ptr->shared_from_this();
+            context ectx{ ctx, ptr, info.bounds };
             return ptr->scroll(ectx, dir, p);
          }
       }
       return false;
    }
 
-   bool composite_base::wants_focus() const
+   void composite_base::update_wants() const
    {
+      cache_lock lock(_cache_mutex);
+      if (_wants_owner == this && _wants_size == size())
+         return;
+
+      _wants_control = false;
+      _wants_focus = false;
       for (std::size_t ix = 0; ix != size(); ++ix)
-         if (at(ix).wants_focus())
-            return true;
-      return false;
+      {
+         auto const& e = at(ix);
+         adopt(e);
+         _wants_control = _wants_control || e.wants_control();
+         _wants_focus = _wants_focus || e.wants_focus();
+      }
+      _wants_size = size();
+      _wants_owner = this;
+   }
+
+   bool composite_base::wants_focus() const
+   {
+      update_wants();
+      return _wants_focus;
    }
 
    void composite_base::begin_focus()
@@ -336,7 +383,7 @@ namespace cycfi { namespace elements
                   context ectx{ ctx, &e, bounds };
                   if (e.hit_test(ectx, p))
                   {
-                     info = hit_info{ e.shared_from_this(), bounds, int(ix) };
+                     info = hit_info{ &e, bounds, int(ix) };
                      return true;
                   }
                }
@@ -344,28 +391,32 @@ namespace cycfi { namespace elements
             return false;
          };
 
-      hit_info info = hit_info{ {}, rect{}, -1 };
+      hit_info info;
+      auto range = hit_range(ctx, p);
       if (reverse_index())
       {
-         for (int ix = int(size())-1; ix >= 0; --ix)
+         for (int ix = int(range.last)-1; ix >= int(range.first); --ix)
             if (test_element(ix, info))
                break;
       }
       else
       {
-         for (std::size_t ix = 0; ix < size(); ++ix)
+         for (std::size_t ix = range.first; ix < range.last; ++ix)
             if (test_element(ix, info))
                break;
       }
       return info;
    }
 
+   composite_base::index_range composite_base::hit_range(context const& /* ctx */, point /* p */) const
+   {
+      return { 0, size() };
+   }
+
    bool composite_base::wants_control() const
    {
-      for (std::size_t ix = 0; ix < size(); ++ix)
-         if (at(ix).wants_control())
-            return true;
-      return false;
+      update_wants();
+      return _wants_control;
    }
 
    void composite_base::reset()
@@ -376,4 +427,20 @@ namespace cycfi { namespace elements
       _cursor_tracking = -1;
       _cursor_hovering.clear();
    }
+
+   void composite_base::take_state(composite_base const& from, std::size_t from_index, std::size_t index)
+   {
+      // The element at index takes over the focus, tracking and hover state
+      // of the element at from_index in from (e.g. when it replaces it)
+      auto from_ix = int(from_index);
+      auto ix = int(index);
+      if (from._focus == from_ix)
+         _focus = ix;
+      if (from._saved_focus == from_ix)
+         _saved_focus = ix;
+      if (from._cursor_tracking == from_ix)
+         _cursor_tracking = ix;
+      if (from._cursor_hovering.count(from_ix))
+         _cursor_hovering.insert(ix);
+   }
 }}
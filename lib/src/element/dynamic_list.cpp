@@ -107,6 +107,7 @@ namespace cycfi { namespace elements
       _update_request = true;
       _rows.clear();
       _height = 0;
+      invalidate_limits();
    }
 
    void dynamic_list::update(basic_context const& ctx) const
@@ -38,6 +38,11 @@ namespace cycfi::elements
 	void element::layout(const context & /* ctx */)
 	{}
 
+	bool element::concurrent_draw() const
+	{
+		return false;
+	}
+
 	void element::refresh(const context & ctx, element& element, int outward)
 	{
         if (&element == this)
@@ -98,8 +103,50 @@ namespace cycfi::elements
         return false;
 	}
 
+	void element::invalidate_limits()
+	{
+		for (const auto & p : _parents)
+		{
+			if (auto anchor = p.lock())
+				(*anchor)->invalidate_limits();
+		}
+	}
+
+	bool element::has_ancestor(const element & e) const
+	{
+		for (const auto & p : _parents)
+		{
+			if (auto anchor = p.lock())
+			{
+				if (*anchor == &e || (*anchor)->has_ancestor(e))
+					return true;
+			}
+		}
+		return false;
+	}
+
 	void element::on_tracking(const context & ctx, tracking state)
 	{
         ctx.view.manage_on_tracking(*this, state);
 	}
+
+	proxy_base* element::as_proxy()
+	{
+		return nullptr;
+	}
+
+	composite_base* element::as_composite()
+	{
+		return nullptr;
+	}
+
+	indirect_base* element::as_indirect()
+	{
+		return nullptr;
+	}
+
+	scrollable* element::as_scrollable()
+	{
+		return nullptr;
+	}
 }
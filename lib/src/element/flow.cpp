@@ -32,6 +32,10 @@ namespace cycfi { namespace elements
    {
       clear();
       _flowable.break_lines(*this, ctx, ctx.bounds.width());
+
+      // The rows are rebuilt from scratch, so the row count alone does not
+      // tell us if our cached limits are still valid.
+      invalidate_limits();
       base_type::layout(ctx);
 
       if (_flowable.needs_reflow())
@@ -5,6 +5,9 @@
 =============================================================================*/
 #include <elements/element/grid.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/trace.hpp>
+
+#include <algorithm>
 
 namespace cycfi { namespace elements
 {
@@ -13,20 +16,26 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    view_limits vgrid_element::limits(basic_context const& ctx) const
    {
-	   view_limits limits{view_limits::init_side::max_x_max_y, full_extent<view_limits::coordinate_type>, 0.0};
-      for (std::size_t i = 0; i != size();  ++i)
+      return cached_limits([&]
       {
-         auto el = at(i).limits(ctx);
-
-         limits.min.y += el.min.y;
-         limits.max.y += el.max.y;
-         clamp_min(limits.min.x, el.min.x);
-         clamp_max(limits.max.x, el.max.x);
-      }
-
-      clamp_min(limits.max.x, limits.min.x);
-      clamp_max(limits.max.y, full_extent<view_limits::coordinate_type>);
-      return limits;
+         view_limits limits{view_limits::init_side::max_x_max_y, full_extent<view_limits::coordinate_type>, 0.0};
+         for (std::size_t i = 0; i != size();  ++i)
+         {
+            auto const& e = at(i);
+            adopt(e);
+            ELEMENTS_TRACE_ZONE("limits", typeid(e));
+            auto el = e.limits(ctx);
+
+            limits.min.y += el.min.y;
+            limits.max.y += el.max.y;
+            clamp_min(limits.min.x, el.min.x);
+            clamp_max(limits.max.x, el.max.x);
+         }
+
+         clamp_min(limits.max.x, limits.min.x);
+         clamp_max(limits.max.y, full_extent<view_limits::coordinate_type>);
+         return limits;
+      });
    }
 
    void vgrid_element::layout(context const& ctx)
@@ -51,6 +60,7 @@ namespace cycfi { namespace elements
          auto y = grid_coord(gi++) * total_height;
          auto height = y - prev;
          rect ebounds = { left, prev+top, right, prev+top+height };
+         ELEMENTS_TRACE_ZONE("layout", typeid(elem));
          elem.layout(context{ ctx, &elem, ebounds });
          _positions[i] = prev+top;
          prev = y;
@@ -67,26 +77,45 @@ namespace cycfi { namespace elements
       return { left, _positions[index], right, _positions[index+1] };
    }
 
+   composite_base::index_range vgrid_element::hit_range(context const& ctx, point p) const
+   {
+      if (_positions.size() != size()+1)
+         return composite_base::hit_range(ctx, p);
+
+      // Element i spans [_positions[i], _positions[i+1]). Find the last
+      // element that starts above p.
+      auto i = std::upper_bound(_positions.begin(), _positions.end()-1, p.y);
+      if (i == _positions.begin())
+         return {};
+      std::size_t ix = (i - _positions.begin()) - 1;
+      return { ix, ix+1 };
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // Horizontal Grids
    ////////////////////////////////////////////////////////////////////////////
    view_limits hgrid_element::limits(basic_context const& ctx) const
    {
-	   view_limits limits{view_limits::init_side::max_x_max_y, 0, full_extent<view_limits::coordinate_type>};
-//      view_limits limits{ { 0.0, 0.0 }, { 0.0, full_extent<view_limits::coordinate_type> } };
-      for (std::size_t i = 0; i != size();  ++i)
+      return cached_limits([&]
       {
-         auto el = at(i).limits(ctx);
-
-         limits.min.x += el.min.x;
-         limits.max.x += el.max.x;
-         clamp_min(limits.min.y, el.min.y);
-         clamp_max(limits.max.y, el.max.y);
-      }
-
-      clamp_min(limits.max.y, limits.min.y);
-      clamp_max(limits.max.x, full_extent<view_limits::coordinate_type>);
-      return limits;
+         view_limits limits{view_limits::init_side::max_x_max_y, 0, full_extent<view_limits::coordinate_type>};
+         for (std::size_t i = 0; i != size();  ++i)
+         {
+            auto const& e = at(i);
+            adopt(e);
+            ELEMENTS_TRACE_ZONE("limits", typeid(e));
+            auto el = e.limits(ctx);
+
+            limits.min.x += el.min.x;
+            limits.max.x += el.max.x;
+            clamp_min(limits.min.y, el.min.y);
+            clamp_max(limits.max.y, el.max.y);
+         }
+
+         clamp_min(limits.max.y, limits.min.y);
+         clamp_max(limits.max.x, full_extent<view_limits::coordinate_type>);
+         return limits;
+      });
    }
 
    void hgrid_element::layout(context const& ctx)
@@ -111,6 +140,7 @@ namespace cycfi { namespace elements
          auto x = grid_coord(gi++) * total_width;
          auto width = x - prev;
          rect ebounds = { prev+left, top, prev+left+width, bottom };
+         ELEMENTS_TRACE_ZONE("layout", typeid(elem));
          elem.layout(context{ ctx, &elem, ebounds });
          _positions[i] = prev+left;
          prev = x;
@@ -126,4 +156,16 @@ namespace cycfi { namespace elements
       auto bottom = ctx.bounds.bottom;
       return { _positions[index], top, _positions[index+1], bottom };
    }
+
+   composite_base::index_range hgrid_element::hit_range(context const& ctx, point p) const
+   {
+      if (_positions.size() != size()+1)
+         return composite_base::hit_range(ctx, p);
+
+      auto i = std::upper_bound(_positions.begin(), _positions.end()-1, p.x);
+      if (i == _positions.begin())
+         return {};
+      std::size_t ix = (i - _positions.begin()) - 1;
+      return { ix, ix+1 };
+   }
 }}
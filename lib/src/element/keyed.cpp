@@ -0,0 +1,144 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/element/keyed.hpp>
+#include <elements/element/composite.hpp>
+#include <elements/element/indirect.hpp>
+#include <elements/support/context.hpp>
+#include <typeinfo>
+#include <utility>
+#include <unordered_map>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   void keyed_element::layout(context const& ctx)
+   {
+      // A reused subject is already laid out at its previous bounds
+      if (std::exchange(_reused, false) && ctx.bounds == _bounds)
+         return;
+
+      proxy_base::layout(ctx);
+      _bounds = ctx.bounds;
+      _laid_out = true;
+   }
+
+   namespace
+   {
+      // The composites an element is in, from the outermost in, with the
+      // index of the child the element is in
+      using composite_path = std::vector<std::pair<composite_base*, std::size_t>>;
+
+      struct keyed_info
+      {
+         keyed_element*       element;
+         composite_path       path;
+      };
+
+      using keyed_map = std::unordered_map<keyed_element::key_type, keyed_info>;
+
+      // F signature: void f(element& child, composite_base* c, std::size_t index)
+      // where c is the composite the child is in, or nullptr.
+      template <typename F>
+      void for_each_child(element& e, F&& f)
+      {
+         if (auto* c = e.as_composite())
+         {
+            for (std::size_t ix = 0; ix != c->size(); ++ix)
+               f(c->at(ix), c, ix);
+         }
+         else if (auto* p = e.as_proxy())
+         {
+            f(p->subject(), nullptr, 0);
+         }
+         else if (auto* i = e.as_indirect())
+         {
+            f(i->get(), nullptr, 0);
+         }
+      }
+
+      template <typename F>
+      void walk(element& e, composite_path& path, F const& f)
+      {
+         if (!f(e, path))
+            return;
+         for_each_child(e,
+            [&](element& child, composite_base* c, std::size_t ix)
+            {
+               if (c)
+                  path.emplace_back(c, ix);
+               walk(child, path, f);
+               if (c)
+                  path.pop_back();
+            }
+         );
+      }
+
+      void take_state(composite_path const& from, composite_path const& to)
+      {
+         auto i = from.rbegin();
+         auto j = to.rbegin();
+         for (; i != from.rend() && j != to.rend(); ++i, ++j)
+         {
+            if (i->first != j->first)
+               j->first->take_state(*i->first, i->second, j->second);
+         }
+      }
+   }
+
+   void reconcile(
+      std::vector<element_ptr> const& current
+    , std::vector<element_ptr> const& next
+   )
+   {
+      keyed_map keyed;
+      composite_path path;
+      for (auto const& e : current)
+      {
+         walk(*e, path,
+            [&](element& e, composite_path const& path)
+            {
+               if (auto* k = dynamic_cast<keyed_element*>(&e))
+                  keyed.emplace(k->key(), keyed_info{ k, path });
+               return true;
+            }
+         );
+      }
+      if (keyed.empty())
+         return;
+
+      for (auto const& e : next)
+      {
+         walk(*e, path,
+            [&](element& e, composite_path const& path)
+            {
+               auto* k = dynamic_cast<keyed_element*>(&e);
+               if (!k)
+                  return true;
+
+               auto i = keyed.find(k->key());
+               if (i == keyed.end() || i->second.element == k)
+                  return true;
+
+               auto& old = *i->second.element;
+               take_state(i->second.path, path);
+
+               bool reuse = old._subject == k->_subject
+                  || (typeid(*old._subject) == typeid(*k->_subject)
+                     && k->_equal && k->_equal(*old._subject, *k->_subject));
+               if (reuse)
+               {
+                  k->_subject = old._subject;
+                  k->_bounds = old._bounds;
+                  k->_laid_out = old._laid_out;
+                  k->_reused = old._laid_out;
+               }
+               keyed.erase(i);
+               return !reuse;
+            }
+         );
+      }
+   }
+}}
@@ -14,21 +14,27 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    view_limits layer_element::limits(basic_context const& ctx) const
    {
-      view_limits limits;
-      for (std::size_t ix = 0; ix != size();  ++ix)
+      return cached_limits([&]
       {
-         auto el = at(ix).limits(ctx);
-
-         clamp_min(limits.min.x, el.min.x);
-         clamp_min(limits.min.y, el.min.y);
-         clamp_max(limits.max.x, el.max.x);
-         clamp_max(limits.max.y, el.max.y);
-
-         limits.max.x = std::max(limits.max.x, limits.min.x);
-         limits.max.y = std::max(limits.max.y, limits.min.y);
-      }
+         view_limits limits;
+         for (std::size_t ix = 0; ix != size();  ++ix)
+         {
+            auto const& e = at(ix);
+            adopt(e);
+            ELEMENTS_TRACE_ZONE("limits", typeid(e));
+            auto el = e.limits(ctx);
+
+            clamp_min(limits.min.x, el.min.x);
+            clamp_min(limits.min.y, el.min.y);
+            clamp_max(limits.max.x, el.max.x);
+            clamp_max(limits.max.y, el.max.y);
+
+            limits.max.x = std::max(limits.max.x, limits.min.x);
+            limits.max.y = std::max(limits.max.y, limits.min.y);
+         }
 
-      return limits;
+         return limits;
+      });
    }
 
    void layer_element::layout(context const& ctx)
@@ -36,6 +42,7 @@ namespace cycfi { namespace elements
       for (std::size_t ix = 0; ix != size(); ++ix)
       {
          auto& e = at(ix);
+         ELEMENTS_TRACE_ZONE("layout", typeid(e));
          e.layout(context{ ctx, &e, bounds_of(ctx, ix) });
       }
    }
@@ -44,12 +51,17 @@ namespace cycfi { namespace elements
    {
       auto width = ctx.bounds.width();
       auto height = ctx.bounds.height();
-      if (_previous_size.x != width || _previous_size.y != height)
-      {
-         _previous_size.x = width;
-         _previous_size.y = height;
-         layout(ctx);
-      }
+      ctx.view.exclusive(
+         [&]()
+         {
+            if (_previous_size.x != width || _previous_size.y != height)
+            {
+               _previous_size.x = width;
+               _previous_size.y = height;
+               layout(ctx);
+            }
+         }
+      );
       composite_base::draw(ctx);
    }
 
@@ -66,11 +78,11 @@ namespace cycfi { namespace elements
             {
                context ectx{ ctx, &e, bounds };
                if (e.hit_test(ectx, p))
-                  return hit_info{ e.shared_from_this(), bounds, int(ix) };
+                  return hit_info{ &e, bounds, int(ix) };
             }
          }
       }
-      return hit_info{ {}, rect{}, -1 };
+      return hit_info{};
    }
 
    rect layer_element::bounds_of(context const& ctx, std::size_t index) const
@@ -117,11 +129,17 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    void deck_element::draw(context const& ctx)
    {
-      if (auto bounds = bounds_of(ctx, _selected_index); bounds.is_intersects(ctx.view_bounds()))
+      if (auto bounds = bounds_of(ctx, _selected_index); bounds.is_intersects(ctx.canvas.clip_extent()))
       {
          auto& elem = at(_selected_index);
          context ectx{ ctx, &elem, bounds };
-         elem.draw(ectx);
+         ctx.view.draw_child(elem, ectx);
+         ctx.view.note_drawn(ectx);
+         ctx.view.count_drawn(1, 0);
+      }
+      else
+      {
+         ctx.view.count_drawn(0, 1);
       }
    }
 
@@ -150,10 +168,10 @@ namespace cycfi { namespace elements
          {
             context ectx{ ctx, &e, bounds };
             if (e.hit_test(ectx, p))
-               return hit_info{ e.shared_from_this(), bounds, int(_selected_index) };
+               return hit_info{ &e, bounds, int(_selected_index) };
          }
       }
-      return hit_info{ {}, rect{}, -1 };
+      return hit_info{};
    }
 
    void deck_element::begin_focus()
@@ -278,10 +278,12 @@ namespace cycfi { namespace elements
    {
       port_element::draw(ctx);
 
+      view_limits e_limits = subject().limits(ctx);
+      _drawn_size = { e_limits.min.x, e_limits.min.y };
+
       if (has_scrollbars())
       {
          scrollbar_bounds  sb = get_scrollbar_bounds(ctx);
-         view_limits       e_limits = subject().limits(ctx);
          point             mp = ctx.cursor_pos();
 
          if (sb.has_v)
@@ -296,15 +298,15 @@ namespace cycfi { namespace elements
    {
       view_limits e_limits = subject().limits(ctx);
       bool redraw = false;
+      double alx = halign();
+      double aly = valign();
 
       if (allow_hscroll())
       {
          double dx = (-dir.x / (e_limits.min.x - ctx.bounds.width()));
          if ((dx > 0 && halign() < 1.0) || (dx < 0 && halign() > 0.0))
          {
-            double alx = halign() + dx;
-            clamp(alx, 0.0, 1.0);
-            halign(alx);
+            alx += dx;
             redraw = true;
          }
       }
@@ -314,18 +316,63 @@ namespace cycfi { namespace elements
          double dy = (-dir.y / (e_limits.min.y - ctx.bounds.height()));
          if ((dy > 0 && valign() < 1.0) || (dy < 0 && valign() > 0.0))
          {
-            double aly = valign() + dy;
-            clamp(aly, 0.0, 1.0);
-            valign(aly);
+            aly += dy;
             redraw = true;
          }
       }
 
       if (redraw)
-         ctx.view.refresh(ctx);
+         scroll_to(ctx, alx, aly);
       return redraw;
    }
 
+   void scroller_base::scroll_to(context const& ctx, double alx, double aly)
+   {
+      clamp(alx, 0.0, 1.0);
+      clamp(aly, 0.0, 1.0);
+
+      view_limits e_limits = subject().limits(ctx);
+      double range_x = e_limits.min.x - ctx.bounds.width();
+      double range_y = e_limits.min.y - ctx.bounds.height();
+      bool blit = (_traits & scroll_blit) && _drawn_size == point{ e_limits.min.x, e_limits.min.y };
+
+      // Snap to whole pixels so that the rendered pixels can be reused
+      if (blit && range_x > 0)
+         alx = std::round(alx * range_x) / range_x;
+      if (blit && range_y > 0)
+         aly = std::round(aly * range_y) / range_y;
+
+      point offset = {
+         float((halign() - alx) * std::max(range_x, 0.0))
+       , float((valign() - aly) * std::max(range_y, 0.0))
+      };
+
+      halign(alx);
+      valign(aly);
+      ctx.view.forget_hit_path();
+
+      if (!blit)
+      {
+         ctx.view.refresh(ctx);
+         return;
+      }
+
+      if (offset.x == 0 && offset.y == 0)
+         return;
+
+      // Shift the subject's pixels and draw only what's newly exposed. The
+      // scroll bars are drawn over the subject, so they moved too.
+      ctx.view.scroll_refresh(ctx, offset);
+      if (has_scrollbars())
+      {
+         scrollbar_bounds sb = get_scrollbar_bounds(ctx);
+         if (sb.has_v)
+            ctx.view.refresh(context{ ctx, sb.vscroll_bounds });
+         if (sb.has_h)
+            ctx.view.refresh(context{ ctx, sb.hscroll_bounds });
+      }
+   }
+
    bool scroller_base::click(context const& ctx, mouse_button btn)
    {
       if (btn.state == mouse_button::what::left && has_scrollbars())
@@ -359,16 +406,12 @@ namespace cycfi { namespace elements
 
       auto valign_ = [&](double align)
       {
-         clamp(align, 0.0, 1.0);
-         valign(align);
-         ctx.view.refresh(ctx);
+         scroll_to(ctx, halign(), align);
       };
 
       auto halign_ = [&](double align)
       {
-         clamp(align, 0.0, 1.0);
-         halign(align);
-         ctx.view.refresh(ctx);
+         scroll_to(ctx, align, valign());
       };
 
       if (sb.has_v)
@@ -458,14 +501,18 @@ namespace cycfi { namespace elements
    {
       if (has_scrollbars())
       {
+         // Only the scroll bars track the mouse
          scrollbar_bounds sb = get_scrollbar_bounds(ctx);
+         if (sb.has_v)
+            ctx.view.refresh(context{ ctx, sb.vscroll_bounds });
+         if (sb.has_h)
+            ctx.view.refresh(context{ ctx, sb.hscroll_bounds });
+
          if (sb.hscroll_bounds.includes(p) || sb.vscroll_bounds.includes(p))
          {
-            ctx.view.refresh(ctx);
             set_cursor(cursor_type::arrow);
             return true;
          }
-         ctx.view.refresh(ctx);
       }
       return port_element::cursor(ctx, p, status);
    }
@@ -519,9 +566,7 @@ namespace cycfi { namespace elements
    {
       auto valign_ = [&](double align)
       {
-         clamp(align, 0.0, 1.0);
-         valign(align);
-         ctx.view.refresh(ctx);
+         scroll_to(ctx, halign(), align);
       };
 
       bool handled = proxy_base::key(ctx, k);
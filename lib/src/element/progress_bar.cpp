@@ -13,6 +13,11 @@ namespace cycfi::elements
 {
    view_limits progress_bar_base::limits(basic_context const& ctx) const
    {
+      // Link the bars, so that changes to their limits reach our parent's
+      // cache
+      adopt(foreground());
+      adopt(background());
+
       auto const fg_limits = foreground().limits(ctx);
       auto       bg_limits = background().limits(ctx);
 
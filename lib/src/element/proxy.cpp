@@ -40,7 +40,19 @@ namespace cycfi::elements
 	{
         context sctx { ctx, &subject(), ctx.bounds };
         prepare_subject(sctx);
-        subject().draw(sctx);
+
+        // Our own bounds were already culled by our parent. Cull again only
+        // if prepare_subject moved the subject (e.g. margins, ports).
+        if (sctx.bounds == ctx.bounds || sctx.bounds.is_intersects(ctx.canvas.clip_extent()))
+        {
+            ctx.view.draw_child(subject(), sctx);
+            ctx.view.note_drawn(sctx);
+            ctx.view.count_drawn(1, 0);
+        }
+        else
+        {
+            ctx.view.count_drawn(0, 1);
+        }
         restore_subject(sctx);
 	}
 
@@ -0,0 +1,54 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/element/record.hpp>
+#include <elements/support/canvas.hpp>
+#include <elements/support/context.hpp>
+#include <elements/view.hpp>
+
+namespace cycfi { namespace elements
+{
+   void record_element::draw(context const& ctx)
+   {
+      // The display list is translation invariant, but not size invariant:
+      // the subject may lay out differently at a different size.
+      if (!_recording
+         || _bounds.width() != ctx.bounds.width()
+         || _bounds.height() != ctx.bounds.height())
+      {
+         ++_stats.misses;
+         record(ctx);
+      }
+      else
+      {
+         ++_stats.hits;
+      }
+
+      auto& cr = ctx.canvas.cairo_context();
+      auto state = ctx.canvas.new_state();
+      ctx.canvas.translate(ctx.bounds.left - _bounds.left, ctx.bounds.top - _bounds.top);
+      cairo_set_source_surface(&cr, _recording.get(), 0, 0);
+      cairo_paint(&cr);
+   }
+
+   void record_element::record(context const& ctx)
+   {
+      // Unbounded, in the same user space as the subject: the subject is
+      // recorded whole, regardless of what is visible now.
+      _recording.reset(cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr));
+      _bounds = ctx.bounds;
+
+      auto* cr = cairo_create(_recording.get());
+      {
+         canvas rec_cnv{ *cr };
+         context sctx{ ctx.view, rec_cnv, &subject(), ctx.bounds };
+         sctx.parent = &ctx;
+         prepare_subject(sctx);
+         subject().draw(sctx);
+         restore_subject(sctx);
+      }
+      cairo_destroy(cr);
+   }
+}}
@@ -0,0 +1,23 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/element/retained.hpp>
+
+namespace cycfi { namespace elements
+{
+   void retained_element::refresh(context const& ctx, element& element, int outward)
+   {
+      // Discard what we kept if the refreshed element is one of ours
+      if (element.has_ancestor(*this))
+         invalidate();
+      proxy_base::refresh(ctx, element, outward);
+   }
+
+   void retained_element::invalidate_limits()
+   {
+      invalidate();
+      proxy_base::invalidate_limits();
+   }
+}}
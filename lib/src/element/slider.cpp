@@ -13,6 +13,11 @@ namespace cycfi { namespace elements
 {
    view_limits slider_base::limits(basic_context const& ctx) const
    {
+      // Link the thumb and track, so that changes to their limits reach
+      // our parent's cache
+      adopt(track());
+      adopt(thumb());
+
       auto  limits_ = track().limits(ctx);
       auto  tmb_limits = thumb().limits(ctx);
 
@@ -9,15 +9,29 @@
 #include <elements/support/text_utils.hpp>
 #include <elements/support/context.hpp>
 #include <elements/view.hpp>
+#include <algorithm>
 #include <utility>
 
 namespace cycfi { namespace elements
 {
    using namespace std::chrono_literals;
 
+   namespace
+   {
+      char const no_text[] = "";
+
+      // The least garbage in a text box's text worth compacting
+      constexpr std::size_t min_garbage = 64 * 1024;
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // Static Text Box
    ////////////////////////////////////////////////////////////////////////////
+   static_text_box::paragraph::paragraph(string_view text_, master_glyphs const& source)
+    : text(text_)
+    , layout(text.data(), text.data() + text.size(), source)
+   {}
+
    static_text_box::static_text_box(
       std::string text
     , font font_
@@ -25,16 +39,15 @@ namespace cycfi { namespace elements
     , color color_
    )
     : _text(std::move(text))
-    , _layout(_text.data(), _text.data() + _text.size(), font_, size)
+    , _layout(no_text, no_text, font_, size)
     , _color(color_)
-   {}
+   {
+      reshape(0, 0, 0, _text.size());
+   }
 
    view_limits static_text_box::limits(basic_context const& /* ctx */) const
    {
-      sync();
-
-      auto  size = _layout.metrics();
-      auto  min_line_height = size.ascent + size.descent + size.leading;
+      auto  min_line_height = line_height();
       float line_height =
          (_current_size.y == -1) ?
          min_line_height :
@@ -46,16 +59,26 @@ namespace cycfi { namespace elements
 
    void static_text_box::layout(context const& ctx)
    {
-      sync();
-
-      _rows.clear();
+      // Rewrap the paragraphs if the width has changed. There is no need
+      // to reshape them.
       auto  new_x = ctx.bounds.width();
-      _layout.break_lines(new_x, _rows);
-      auto  size = _layout.metrics();
-      auto  new_y = _rows.size() * (size.ascent + size.descent + size.leading);
+      if (_current_size.x != new_x)
+      {
+         for (auto& p : _paragraphs)
+            wrap(*p, new_x);
+         update_positions(0);
+      }
+      auto  new_y = height();
 
-      // Refresh the union of the old and new bounds if the size has changed
-      if (_current_size.x != new_x || _current_size.y != new_y)
+      auto refresh = [&ctx](float top, float bottom)
+      {
+         auto tl = ctx.canvas.user_to_device(point{ ctx.bounds.left, ctx.bounds.top + top });
+         auto br = ctx.canvas.user_to_device(point{ ctx.bounds.right, ctx.bounds.top + bottom });
+         ctx.view.refresh(rect{ tl.x, tl.y, br.x, br.y });
+      };
+
+      // Refresh the union of the old and new bounds if the width has changed
+      if (_current_size.x != new_x)
       {
          if (_current_size.x != -1 && _current_size.y != -1)
             ctx.view.refresh(ctx.bounds.reconstruct_max_with(rect(ctx.bounds.left_top(), extent{_current_size.x, _current_size.y})));
@@ -63,6 +86,22 @@ namespace cycfi { namespace elements
             ctx.view.refresh(ctx.bounds);
       }
 
+      // Otherwise, refresh only the edited rows. If the height has changed,
+      // the rows below them have moved too.
+      else if (_current_size.y != new_y)
+      {
+         refresh(std::max(_dirty_top, 0.0f), std::max(_current_size.y, new_y));
+      }
+      else if (_dirty_top != -1)
+      {
+         refresh(_dirty_top, _dirty_bottom);
+      }
+      _dirty_top = _dirty_bottom = -1;
+
+      // Our limits depend on the height of the text
+      if (_current_size.y != new_y)
+         invalidate_limits();
+
       _current_size.x = new_x;
       _current_size.y = new_y;
    }
@@ -74,36 +113,201 @@ namespace cycfi { namespace elements
       auto  metrics = _layout.metrics();
       auto  line_height = metrics.ascent + metrics.descent + metrics.leading;
       auto  x = ctx.bounds.left;
-      auto  y = ctx.bounds.top + metrics.ascent;
       auto  clip_extent = cnv.clip_extent();
+      auto  bottom = std::min(ctx.bounds.bottom, clip_extent.bottom);
 
       cnv.rect(ctx.bounds);
       cnv.clip();
       cnv.fill_style(_color);
-      for (auto& row : _rows)
+
+      // Start from the first paragraph that is not clipped out
+      auto i = paragraph_at_y(clip_extent.top - ctx.bounds.top);
+      for (; i != _paragraphs.size(); ++i)
       {
-         if (y + metrics.descent > clip_extent.top)
-            row.draw({ x, y }, cnv);
-         y += line_height;
-         if (y > ctx.bounds.bottom + metrics.ascent)
+         auto& p = *_paragraphs[i];
+         auto  y = ctx.bounds.top + p.y + metrics.ascent;
+         if (y > bottom + metrics.ascent)
             break;
+
+         for (auto& row : p.rows)
+         {
+            if (y + metrics.descent > clip_extent.top)
+               row.draw({ x, y }, cnv);
+            y += line_height;
+            if (y > bottom + metrics.ascent)
+               break;
+         }
       }
    }
 
-   void static_text_box::sync() const
+   void static_text_box::set_text(string_view text)
    {
-      auto f = _text.data();
-      auto l = _text.data() + _text.size();
-      if (f != _layout.begin() || l != _layout.end())
-         _layout.text(f, l);
+      _text.assign(text);
+      reshape(0, _paragraphs.size(), 0, _text.size());
+      invalidate_limits();
    }
 
-   void static_text_box::set_text(string_view text)
+   void static_text_box::replace(std::size_t pos, std::size_t count, string_view text)
    {
-      _text = std::string(text);
-      _rows.clear();
-      _layout.text(_text.data(), _text.data() + _text.size());
-      _layout.break_lines(_current_size.x, _rows);
+      // An undo record may outlive the text it was made for (see set_text)
+      pos = std::min(pos, _text.size());
+      count = std::min(count, _text.size() - pos);
+
+      // Reshape the paragraphs from the one where the replaced text starts
+      // to the one where it ends.
+      auto  first = paragraph_at(pos);
+      auto  last = paragraph_at(pos + count);
+      auto  start = _paragraphs[first]->offset;
+      auto  end = _paragraphs[last]->offset + _paragraphs[last]->text.size();
+
+      _text.replace(pos, count, text);
+      reshape(first, last + 1, start, end + text.size() - count);
+   }
+
+   void static_text_box::mark_dirty(std::size_t pos, std::size_t end)
+   {
+      // Refresh the rows of the paragraphs of _text[pos, end] on the next
+      // layout, even if their text is not edited.
+      if (_paragraphs.empty())
+         return;
+
+      auto& first = *_paragraphs[paragraph_at(pos)];
+      auto& last = *_paragraphs[paragraph_at(end)];
+      auto  top = first.y;
+      auto  bottom = last.y + (last.num_rows() * line_height());
+      _dirty_top = (_dirty_top == -1)? top : std::min(_dirty_top, top);
+      _dirty_bottom = std::max(_dirty_bottom, bottom);
+   }
+
+   std::size_t static_text_box::paragraph_at(std::size_t pos) const
+   {
+      auto i = std::upper_bound(_paragraphs.begin(), _paragraphs.end(), pos,
+         [](std::size_t pos, paragraph_ptr const& p) { return pos < p->offset; }
+      );
+      return (i == _paragraphs.begin())? 0 : (i - _paragraphs.begin()) - 1;
+   }
+
+   std::size_t static_text_box::paragraph_at_y(float y) const
+   {
+      auto i = std::upper_bound(_paragraphs.begin(), _paragraphs.end(), y,
+         [](float y, paragraph_ptr const& p) { return y < p->y; }
+      );
+      return (i == _paragraphs.begin())? 0 : (i - _paragraphs.begin()) - 1;
+   }
+
+   float static_text_box::line_height() const
+   {
+      auto  metrics = _layout.metrics();
+      return metrics.ascent + metrics.descent + metrics.leading;
+   }
+
+   float static_text_box::height() const
+   {
+      if (_paragraphs.empty())
+         return 0;
+      auto& last = *_paragraphs.back();
+      return last.y + (last.num_rows() * line_height());
+   }
+
+   void static_text_box::reshape(
+      std::size_t first, std::size_t last
+    , std::size_t start, std::size_t end
+   )
+   {
+      // Replace the paragraphs [first, last) with those of _text[start, end),
+      // reusing the paragraphs we already have.
+      auto  old_top = (first < _paragraphs.size())? _paragraphs[first]->y : height();
+      auto  old_bottom = (first < last)?
+         _paragraphs[last-1]->y + (_paragraphs[last-1]->num_rows() * line_height()) :
+         old_top;
+
+      auto  i = first;
+      auto  edited = _text.contiguous(start, end - start);
+      char const* f = edited.data();
+      char const* last_p = f + edited.size();
+      while (true)
+      {
+         char const* l = std::find(f, last_p, '\n');
+         string_view text{ f, std::size_t(l - f) };
+
+         if (i < last)
+         {
+            auto& p = *_paragraphs[i];
+            p.text = text;
+            p.layout.text(p.text.data(), p.text.data() + p.text.size());
+         }
+         else
+         {
+            _paragraphs.insert(_paragraphs.begin() + i, std::make_unique<paragraph>(text, _layout));
+            ++last;
+         }
+         wrap(*_paragraphs[i++], _current_size.x);
+
+         if (l == last_p)
+            break;
+         f = l + 1; // skip the newline
+      }
+      _paragraphs.erase(_paragraphs.begin() + i, _paragraphs.begin() + last);
+      update_positions(first);
+
+      auto& p = *_paragraphs[i-1];
+      auto  new_bottom = p.y + (p.num_rows() * line_height());
+      auto  top = old_top;
+      auto  bottom = std::max(old_bottom, new_bottom);
+      _dirty_top = (_dirty_top == -1)? top : std::min(_dirty_top, top);
+      _dirty_bottom = std::max(_dirty_bottom, bottom);
+
+      // The copies made by _text.contiguous leave the text they replace
+      // behind. Compact it when it outgrows the text.
+      if (_text.garbage() > std::max(_text.size(), min_garbage))
+         compact();
+   }
+
+   void static_text_box::compact()
+   {
+      // Move the text to a single buffer, and point the paragraphs, and the
+      // glyphs shaped from them, to their text there.
+      _text.compact();
+      auto all = _text.contiguous(0, _text.size());
+      for (auto& p_ : _paragraphs)
+      {
+         auto& p = *p_;
+         auto  text = all.substr(p.offset, p.text.size());
+         for (auto& row : p.rows)
+            row.rebase(text.data() + (row.begin() - p.text.data()));
+         p.layout.rebase(text.data());
+         p.text = text;
+      }
+   }
+
+   void static_text_box::wrap(paragraph& p, float width)
+   {
+      // Nothing to wrap until we know our width
+      p.rows.clear();
+      if (width != -1)
+         p.layout.break_lines(width, p.rows);
+   }
+
+   void static_text_box::update_positions(std::size_t first)
+   {
+      auto  line_height = this->line_height();
+      auto  y = 0.0f;
+      auto  offset = std::size_t(0);
+      if (first > 0)
+      {
+         auto& prev = *_paragraphs[first-1];
+         y = prev.y + (prev.num_rows() * line_height);
+         offset = prev.offset + prev.text.size() + 1;
+      }
+
+      for (auto i = first; i != _paragraphs.size(); ++i)
+      {
+         auto& p = *_paragraphs[i];
+         p.y = y;
+         p.offset = offset;
+         y += p.num_rows() * line_height;
+         offset += p.text.size() + 1;
+      }
    }
 
    void static_text_box::value(string_view val)
@@ -114,14 +318,27 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    // Editable Text Box
    ////////////////////////////////////////////////////////////////////////////
+   struct basic_text_box::edit_record
+   {
+      int            pos;              // Where the text was replaced
+      std::string    removed;          // The text that was replaced
+      std::string    inserted;         // The text that replaced it
+      int            select_start;     // The selection before the edit
+      int            select_end;
+      std::uint32_t  generation;       // The text it was made for (see set_text)
+      view::undo_id  undo = 0;         // Its task in the view's undo history
+   };
+
    basic_text_box::basic_text_box(std::string text, font font_, float size)
     : static_text_box(std::move(text), font_, size)
     , _select_start(-1)
     , _select_end(-1)
     , _current_x(0)
+    , _generation(0)
     , _is_focus(false)
     , _show_caret(true)
     , _caret_started(false)
+    , _undo_stale(false)
    {}
 
    basic_text_box::~basic_text_box()
@@ -151,44 +368,37 @@ namespace cycfi { namespace elements
          return true;
       }
 
-      char const*   _first = _text.data();
-      char const*   _last = _first + _text.size();
+      int   last = int(_text.size());
+      int   pos = caret_position(ctx, btn.pos);
 
-      if (char const* pos = caret_position(ctx, btn.pos))
+      if (pos != -1)
       {
          if (btn.num_clicks != 1)
          {
-            char const* end = pos;
-            char const* start = pos;
-
-            auto fixup = [&]()
-            {
-               if (start != _first)
-                  start = next_utf8(_last, start);
-               _select_start = int(start - _first);
-               _select_end = int(end - _first);
-            };
+            int end = pos;
+            int start = pos;
 
             if (btn.num_clicks == 2)
             {
-               while (end < _last && !word_break(end))
-                  end = next_utf8(_last, end);
-               while (start > _first && !word_break(start))
-                  start = prev_utf8(_first, start);
-               fixup();
+               while (end < last && !word_break(utf8_at(end)))
+                  end = next_index(end);
+               while (start > 0 && !word_break(utf8_at(start)))
+                  start = prev_index(start);
+               if (start != 0)
+                  start = next_index(start);
+               _select_start = start;
+               _select_end = end;
             }
             else if (btn.num_clicks == 3)
             {
-               while (end < _last && !is_newline(uint8_t(*end)))
-                  end++;
-               while (start > _first && !is_newline(uint8_t(*start)))
-                  start--;
-               fixup();
+               auto& para = *_paragraphs[paragraph_at(pos)];
+               _select_start = int(para.offset);
+               _select_end = int(para.offset + para.text.size());
             }
          }
          else
          {
-            auto hit = int(pos - _first);
+            auto hit = pos;
             if ((btn.modifiers == mod_shift) && (_select_start != -1))
             {
                if (hit < _select_start)
@@ -209,10 +419,10 @@ namespace cycfi { namespace elements
 
    void basic_text_box::drag(context const& ctx, mouse_button btn)
    {
-      char const* first = &_text[0];
-      if (char const* pos = caret_position(ctx, btn.pos))
+      int pos = caret_position(ctx, btn.pos);
+      if (pos != -1)
       {
-         _select_end = int(pos-first);
+         _select_end = pos;
          ctx.view.refresh(ctx);
          scroll_into_view(ctx, true);
       }
@@ -228,24 +438,6 @@ namespace cycfi { namespace elements
       return false;
    }
 
-   namespace
-   {
-      void add_undo(
-         context const& ctx
-       , std::function<void()>& typing_state
-       , std::function<void()> undo_f
-       , std::function<void()> redo_f
-      )
-      {
-         if (typing_state)
-         {
-            ctx.view.add_undo({ typing_state, undo_f });
-            typing_state = {}; // reset
-         }
-         ctx.view.add_undo({ undo_f, redo_f });
-      }
-   }
-
    void break_()
    {
    }
@@ -253,6 +445,7 @@ namespace cycfi { namespace elements
    bool basic_text_box::text(context const& ctx, text_info info_)
    {
       _show_caret = true;
+      clear_stale_undo(ctx.view);
 
       if (_select_start == -1)
          return false;
@@ -262,39 +455,49 @@ namespace cycfi { namespace elements
 
       std::string text = codepoint_to_utf8(info_.codepoint);
 
-      if (!_typing_state)
-         _typing_state = capture_state();
-
-      bool replace = false;
-      if (_select_start == _select_end)
+      // Typing at the end of the typing run extends it, if its task is
+      // still the newest in the undo history. Otherwise, this starts a new
+      // one.
+      bool replacing = _select_start != _select_end;
+      if (!replacing && _typing
+         && _select_start == int(_typing->pos + _typing->inserted.size())
+         && ctx.view.grow_undo(_typing->undo, text.size()))
       {
-         _text.insert(_select_start, text);
+         replace(_select_start, 0, text);
+         _typing->inserted += text;
       }
       else
       {
-         _text.replace(_select_start, _select_end-_select_start, text);
-         replace = true;
+         edit(_select_start, _select_end-_select_start, text);
+         _typing = _edit;
+         add_undo(ctx.view);
       }
-
-      _layout.text(_text.data(), _text.data() + _text.size());
       layout(ctx);
 
-      if (replace)
+      // The layout refreshed the edited rows, with the caret and selection
+      if (replacing)
       {
          _select_end = _select_start;
-         scroll_into_view(ctx, true);
+         scroll_into_view(ctx, true, false);
          _select_end = _select_start += text.length();
       }
       else
       {
          _select_end = _select_start += text.length();
-         scroll_into_view(ctx, true);
+         scroll_into_view(ctx, true, false);
       }
       return true;
    }
 
    void basic_text_box::set_text(string_view text_)
    {
+      // The edits in the undo history are for the old text: they are
+      // ignored from now on, and removed from the history the next time
+      // we have the view (see clear_stale_undo).
+      _edit.reset();
+      _typing.reset();
+      ++_generation;
+      _undo_stale = true;
       static_text_box::set_text(text_);
       _select_start = std::min<int>(_select_start, text_.size());
       _select_end = std::min<int>(_select_end, text_.size());
@@ -303,6 +506,7 @@ namespace cycfi { namespace elements
    bool basic_text_box::key(context const& ctx, key_info k)
    {
       _show_caret = true;
+      clear_stale_undo(ctx.view);
 
       if (_select_start == -1
          || k.action == key_action::release
@@ -313,23 +517,23 @@ namespace cycfi { namespace elements
       bool move_caret = false;
       bool save_x = false;
       bool handled = false;
+      bool edited = false;
 
       int start = std::min(_select_end, _select_start);
       int end = std::max(_select_end, _select_start);
-      std::function<void()> undo_f = capture_state();
 
       auto up_down = [this, &ctx, k, &move_caret]()
       {
          bool up = k.key == key_code::up;
          glyph_metrics info;
-         info = glyph_info(ctx, &_text[_select_end]);
-         if (info.str)
+         info = glyph_info(ctx, _select_end);
+         if (info.index != -1)
          {
             auto y = up ? -info.line_height : +info.line_height;
             auto pos = point{ ctx.bounds.left + _current_x, info.pos.y + y };
-            char const* cp = caret_position(ctx, pos);
-            if (cp)
-               _select_end = int(cp - &_text[0]);
+            int cp = caret_position(ctx, pos);
+            if (cp != -1)
+               _select_end = cp;
             else
                _select_end = up ? 0 : int(_text.size());
             move_caret = true;
@@ -339,34 +543,26 @@ namespace cycfi { namespace elements
       auto next_char = [this]()
       {
          if (_select_end < static_cast<int>(_text.size()))
-         {
-            char const* end = _text.data() + _text.size();
-            char const* p = next_utf8(end, &_text[_select_end]);
-            _select_end = int(p - &_text[0]);
-         }
+            _select_end = next_index(_select_end);
       };
 
       auto prev_char = [this]()
       {
          if (_select_end > 0)
-         {
-            char const* start = &_text[0];
-            char const* p = prev_utf8(start, &_text[_select_end]);
-            _select_end = int(p - &_text[0]);
-         }
+            _select_end = prev_index(_select_end);
       };
 
       auto next_word = [this]()
       {
          if (_select_end < static_cast<int>(_text.size()))
          {
-            char const* p = &_text[_select_end];
-            char const* end = _text.data() + _text.size();
-            while (p != end && word_break(p))
-               p = next_utf8(end, p);
-            while (p != end && !word_break(p))
-               p = next_utf8(end, p);
-            _select_end = int(p - &_text[0]);
+            int p = _select_end;
+            int end = int(_text.size());
+            while (p != end && word_break(utf8_at(p)))
+               p = next_index(p);
+            while (p != end && !word_break(utf8_at(p)))
+               p = next_index(p);
+            _select_end = p;
          }
       };
 
@@ -374,18 +570,14 @@ namespace cycfi { namespace elements
       {
          if (_select_end > 0)
          {
-            char const* start = &_text[0];
-            char const* p = prev_utf8(start, &_text[_select_end]);
-            while (p != start && word_break(p))
-               p = prev_utf8(start, p);
-            while (p != start && !word_break(p))
-               p = prev_utf8(start, p);
-            if (p != start)
-            {
-               char const* end = _text.data() + _text.size();
-               p = next_utf8(end, p);
-            }
-            _select_end = int(p - &_text[0]);
+            int p = prev_index(_select_end);
+            while (p != 0 && word_break(utf8_at(p)))
+               p = prev_index(p);
+            while (p != 0 && !word_break(utf8_at(p)))
+               p = prev_index(p);
+            if (p != 0)
+               p = next_index(p);
+            _select_end = p;
          }
       };
 
@@ -395,12 +587,12 @@ namespace cycfi { namespace elements
          {
             case key_code::enter:
                {
-                  _text.replace(start, end-start, "\n");
-                  _select_start += 1;
+                  edit(start, end-start, "\n");
+                  _select_start = start + 1;
                   _select_end = _select_start;
                   save_x = true;
-                  add_undo(ctx, _typing_state, undo_f, capture_state());
-                  handled = true;
+                  add_undo(ctx.view);
+                  handled = edited = true;
                }
                break;
 
@@ -409,8 +601,8 @@ namespace cycfi { namespace elements
                {
                   delete_(k.key == key_code::_delete);
                   save_x = true;
-                  add_undo(ctx, _typing_state, undo_f, capture_state());
-                  handled = true;
+                  add_undo(ctx.view);
+                  handled = edited = true;
                }
                break;
 
@@ -465,8 +657,8 @@ namespace cycfi { namespace elements
                {
                   cut(ctx.view, start, end);
                   save_x = true;
-                  add_undo(ctx, _typing_state, undo_f, capture_state());
-                  handled = true;
+                  add_undo(ctx.view);
+                  handled = edited = true;
                }
                break;
 
@@ -483,25 +675,19 @@ namespace cycfi { namespace elements
                {
                   paste(ctx.view, start, end);
                   save_x = true;
-                  add_undo(ctx, _typing_state, undo_f, capture_state());
-                  handled = true;
+                  add_undo(ctx.view);
+                  handled = edited = true;
                }
                break;
 
             case key_code::z:
                if (k.modifiers & mod_action)
                {
-                  if (_typing_state)
-                  {
-                     ctx.view.add_undo({ _typing_state, undo_f });
-                     _typing_state = {}; // reset
-                  }
-
                   if (k.modifiers & mod_shift)
                      ctx.view.redo();
                   else
                      ctx.view.undo();
-                  handled = true;
+                  handled = edited = true;
                }
                break;
 
@@ -517,15 +703,21 @@ namespace cycfi { namespace elements
          if (!(k.modifiers & mod_shift))
             _select_start = _select_end;
       }
-      else if (handled)
+      else if (edited)
       {
-         _layout.text(_text.data(), _text.data() + _text.size());
+         // Refreshes the edited rows
          layout(ctx);
+      }
+      else if (handled)
+      {
          ctx.view.refresh(ctx);
       }
 
       if (handled)
-         scroll_into_view(ctx, save_x);
+      {
+         _typing.reset();
+         scroll_into_view(ctx, save_x, !edited);
+      }
       return handled;
    }
 
@@ -568,7 +760,7 @@ namespace cycfi { namespace elements
       // Draw the caret
       else if (_is_focus && (_select_start != -1) && (_select_start == _select_end))
       {
-         auto  start_info = glyph_info(ctx, _text.data() + _select_start);
+         auto  start_info = glyph_info(ctx, _select_start);
          auto width = theme.text_box_caret_width;
          rect& caret = start_info.bounds;
 
@@ -613,11 +805,11 @@ namespace cycfi { namespace elements
 
       if (!_text.empty())
       {
-         auto  start_info = glyph_info(ctx, _text.data() + _select_start);
+         auto  start_info = glyph_info(ctx, _select_start);
          rect& r1 = start_info.bounds;
          r1.right = ctx.bounds.right;
 
-         auto  end_info = glyph_info(ctx, _text.data() + _select_end);
+         auto  end_info = glyph_info(ctx, _select_end);
          rect& r2 = end_info.bounds;
          r2.right = r2.left;
          r2.left = ctx.bounds.left;
@@ -647,115 +839,134 @@ namespace cycfi { namespace elements
       }
    }
 
-   char const* basic_text_box::caret_position(context const& ctx, point p)
+   int basic_text_box::caret_position(context const& ctx, point p)
    {
       auto  x = ctx.bounds.left;
-      auto  y = ctx.bounds.top;
-      auto  metrics = _layout.metrics();
-      auto  line_height = metrics.ascent + metrics.descent + metrics.leading;
+      auto  line_height = this->line_height();
+
+      if (p.y < ctx.bounds.top || p.y >= ctx.bounds.top + height())
+         return -1;
 
-      char const* found = nullptr;
-      for (auto& row : _rows)
+      // Find the paragraph, then the row within it
+      auto& para = *_paragraphs[paragraph_at_y(p.y - ctx.bounds.top)];
+      char const* found = para.text.data();
+      if (!para.rows.empty())
       {
-         // Check if p is within this row
-         if ((p.y >= y) && (p.y < y + line_height))
-         {
-            // Check if we are at the very start of the row or beyond
-            if (p.x <= x)
-            {
-               found = row.begin();
-               break;
-            }
+         auto  i = std::size_t((p.y - ctx.bounds.top - para.y) / line_height);
+         auto& row = para.rows[std::min(i, para.rows.size()-1)];
 
+         // Check if we are at the very start of the row or beyond
+         if (p.x <= x)
+         {
+            found = row.begin();
+         }
+         else
+         {
             // Get the actual coordinates of the glyph
-            row.for_each(
-               [p, x, &found](char const* utf8, float left, float right)
-               {
-                  if ((p.x >= (x + left)) && (p.x < (x + right)))
-                  {
-                     found = utf8;
-                     return false;
-                  }
-                  return true;
-               }
-            );
+            found = row.cluster_at(p.x - x).utf8;
+
             // Assume it's at the end of the row if we haven't found a hit
             if (!found)
                found = row.end();
-            break;
          }
-         y += line_height;
       }
-      return found;
+      return int(para.offset + (found - para.text.data()));
    }
 
-   basic_text_box::glyph_metrics basic_text_box::glyph_info(context const& ctx, char const* s)
+   basic_text_box::glyph_metrics basic_text_box::glyph_info(context const& ctx, int index)
    {
       auto  metrics = _layout.metrics();
       auto  x = ctx.bounds.left;
-      auto  y = ctx.bounds.top + metrics.ascent;
       auto  descent = metrics.descent;
       auto  ascent = metrics.ascent;
       auto  leading = metrics.leading;
       auto  line_height = ascent + descent + leading;
 
       glyph_metrics info;
-      info.str = nullptr;
+      info.index = -1;
       info.line_height = line_height;
 
-      // Check if s is at the very end
-      if (s == _text.data() + _text.size())
+      // Find the paragraph, and where the glyph is in its text
+      auto& para = *_paragraphs[paragraph_at(index)];
+      char const* ps = para.text.data() + (index - para.offset);
+      auto  y = ctx.bounds.top + para.y + ascent;
+
+      auto to_index = [&](char const* p)
       {
-         auto const& last_row = _rows.back();
-         auto        rightmost = x + last_row.width();
-         auto        bottom_y = y + (line_height * (_rows.size() - 1));
-
-         info.pos = { rightmost, bottom_y };
-         info.bounds = { rightmost, bottom_y - ascent, rightmost + 10, bottom_y + descent };
-         info.str = s;
-         return info;
-      }
+         return int(para.offset + (p - para.text.data()));
+      };
+
+      auto at_end_of = [&](glyphs const* row, float row_y)
+      {
+         auto  rightmost = x + (row? row->width() : 0);
+         info.pos = { rightmost, row_y };
+         info.bounds = { rightmost, row_y - ascent, rightmost + 10, row_y + descent };
+         info.index = index;
+      };
 
-      glyphs*  prev_row = nullptr;
-      for (auto& row : _rows)
+      glyphs const* prev_row = nullptr;
+      for (auto const& row : para.rows)
       {
-         // Check if s is within this row
-         if (s >= row.begin() && s < row.end())
+         // Check if the glyph is within this row
+         if (ps >= row.begin() && ps < row.end())
          {
             // Get the actual coordinates of the glyph
-            row.for_each(
-               [s, &info, x, y, ascent, descent](char const* utf8, float left, float right)
-               {
-                  if (utf8 >= s)
-                  {
-                     info.pos = { x + left, y };
-                     info.bounds = { x + left, y - ascent, x + right, y + descent };
-                     info.str = utf8;
-                     return false;
-                  }
-                  return true;
-               }
-            );
-            break;
+            if (auto c = row.cluster_from(ps); c.utf8)
+            {
+               info.pos = { x + c.left, y };
+               info.bounds = { x + c.left, y - ascent, x + c.right, y + descent };
+               info.index = to_index(c.utf8);
+            }
+            return info;
          }
-         // This handles the case where s is in between the start of the
-         // current row and the end of the previous.
-         else if (s < row.begin() && prev_row)
+         // This handles the case where the glyph is in between the start
+         // of the current row and the end of the previous.
+         else if (ps < row.begin() && prev_row)
          {
-            auto  rightmost = x + prev_row->width();
-            auto  prev_y = y - line_height;
-            info.pos = { rightmost, prev_y };
-            info.bounds = { rightmost, prev_y - ascent, rightmost + 10, prev_y + descent };
-            info.str = s;
-            break;
+            at_end_of(prev_row, y - line_height);
+            return info;
          }
          y += line_height;
          prev_row = &row;
       }
 
+      // The glyph is at the end of the paragraph (at its newline or at the end of
+      // the text)
+      at_end_of(prev_row, prev_row? y - line_height : y);
       return info;
    }
 
+   int basic_text_box::next_index(int index) const
+   {
+      auto& para = *_paragraphs[paragraph_at(index)];
+      auto  i = std::size_t(index) - para.offset;
+      if (i >= para.text.size())
+         return std::min(index + 1, int(_text.size()));
+
+      char const* s = para.text.data() + i;
+      return index + int(next_utf8(para.text.data() + para.text.size(), s) - s);
+   }
+
+   int basic_text_box::prev_index(int index) const
+   {
+      auto& para = *_paragraphs[paragraph_at(index)];
+      auto  i = std::size_t(index) - para.offset;
+      if (i == 0)
+         return std::max(index - 1, 0);
+
+      char const* s = para.text.data() + i;
+      return index - int(s - prev_utf8(para.text.data(), s));
+   }
+
+   char const* basic_text_box::utf8_at(int index) const
+   {
+      auto& para = *_paragraphs[paragraph_at(index)];
+      auto  i = std::size_t(index) - para.offset;
+      if (i < para.text.size())
+         return para.text.data() + i;
+      return (&para == _paragraphs.back().get())? no_text : "\n";
+   }
+
    void basic_text_box::delete_(bool forward)
    {
       auto  start = std::min(_select_end, _select_start);
@@ -766,24 +977,19 @@ namespace cycfi { namespace elements
          {
             if (forward)
             {
-               char const* start_p = &_text[start];
-               char const* end_p = &_text[0] + _text.size();
-               char const* p = next_utf8(end_p, start_p);
-               start = int(start_p - &_text[0]);
-               _text.erase(start, p - start_p);
+               int p = next_index(start);
+               edit(start, p - start, "");
             }
             else if (start > 0)
             {
-               char const* start_p = &_text[0];
-               char const* end_p = &_text[start];
-               char const* p = prev_utf8(start_p, end_p);
-               start = int(p - &_text[0]);
-               _text.erase(start, end_p - p);
+               int p = prev_index(start);
+               edit(p, start - p, "");
+               start = p;
             }
          }
          else
          {
-            _text.erase(start, end-start);
+            edit(start, end-start, "");
          }
          _select_end = _select_start = start;
       }
@@ -817,46 +1023,86 @@ namespace cycfi { namespace elements
          auto  end_ = std::max(start, end);
          auto  start_ = std::min(start, end);
          std::string ins = clipboard();
-         _text.replace(start, end_-start_, ins);
+         edit(start, end_-start_, ins);
          start += ins.size();
          _select_end = _select_start = start;
       }
    }
 
-   struct basic_text_box::state_saver
+   void basic_text_box::edit(int pos, int count, string_view text)
    {
-      state_saver(basic_text_box* this_)
-       : text(this_->_text)
-       , select_start(this_->_select_start)
-       , select_end(this_->_select_end)
-       , save_text(this_->_text)
-       , save_select_start(this_->_select_start)
-       , save_select_end(this_->_select_end)
-      {}
-
-      void operator()()
+      auto r = std::make_shared<edit_record>();
+      r->pos = pos;
+      r->removed = _text.substr(pos, count);
+      r->inserted = std::string(text);
+      r->select_start = _select_start;
+      r->select_end = _select_end;
+      r->generation = _generation;
+
+      replace(pos, count, text);
+      _edit = std::move(r);
+   }
+
+   void basic_text_box::add_undo(view& v)
+   {
+      if (!_edit)
+         return;
+
+      // The typing run may still be extended after this: text() adds to
+      // the size of its task as it does (see view::grow_undo).
+      auto r = std::move(_edit);
+      auto size = sizeof(edit_record) + r->removed.size() + r->inserted.size();
+
+      // The selection moves, maybe to rows the edit does not touch: the
+      // rows of the old and new selection are refreshed with the edit's.
+      auto undo_f = [this, r]()
       {
-         text = save_text;
-         select_start = save_select_start;
-         select_end = save_select_end;
-      }
+         if (r->generation != _generation)
+            return;
+         _typing.reset();
+         mark_selection_dirty();
+         replace(r->pos, r->inserted.size(), r->removed);
+         select_start(r->select_start);
+         select_end(r->select_end);
+         mark_selection_dirty();
+      };
+
+      // After an edit, the caret is always after the inserted text
+      auto redo_f = [this, r]()
+      {
+         if (r->generation != _generation)
+            return;
+         _typing.reset();
+         mark_selection_dirty();
+         replace(r->pos, r->removed.size(), r->inserted);
+         select_start(r->pos + int(r->inserted.size()));
+         select_end(r->pos + int(r->inserted.size()));
+         mark_selection_dirty();
+      };
 
-      std::string&   text;
-      int&           select_start;
-      int&           select_end;
+      r->undo = v.add_undo({ undo_f, redo_f, size, this });
+   }
 
-      std::string    save_text;
-      int            save_select_start;
-      int            save_select_end;
-   };
+   void basic_text_box::clear_stale_undo(view& v)
+   {
+      if (_undo_stale)
+      {
+         v.clear_undo(this);
+         _undo_stale = false;
+      }
+   }
 
-   std::function<void()>
-   basic_text_box::capture_state()
+   void basic_text_box::mark_selection_dirty()
    {
-      return state_saver(this);
+      if (_select_start == -1 || _select_end == -1)
+         return;
+      mark_dirty(
+         std::min(_select_start, _select_end)
+       , std::max(_select_start, _select_end)
+      );
    }
 
-   void basic_text_box::scroll_into_view(context const& ctx, bool save_x)
+   void basic_text_box::scroll_into_view(context const& ctx, bool save_x, bool refresh)
    {
       if (_text.empty())
       {
@@ -867,7 +1113,8 @@ namespace cycfi { namespace elements
             ctx.bounds.bottom
          };
          scrollable::find(ctx).scroll_into_view(caret);
-         ctx.view.refresh(ctx);
+         if (refresh)
+            ctx.view.refresh(ctx);
          if (save_x)
             _current_x = 0;
          return;
@@ -876,8 +1123,8 @@ namespace cycfi { namespace elements
       if (_select_end == -1)
          return;
 
-      auto info = glyph_info(ctx, &_text[_select_end]);
-      if (info.str)
+      auto info = glyph_info(ctx, _select_end);
+      if (info.index != -1)
       {
          auto caret = rect{
             info.bounds.left-1,
@@ -885,7 +1132,7 @@ namespace cycfi { namespace elements
             info.bounds.left+1,
             info.bounds.bottom
          };
-         if (!scrollable::find(ctx).scroll_into_view(caret))
+         if (!scrollable::find(ctx).scroll_into_view(caret) && refresh)
             ctx.view.refresh(ctx);
 
          if (save_x)
@@ -908,6 +1155,7 @@ namespace cycfi { namespace elements
    void basic_text_box::end_focus()
    {
       _is_focus = false;
+      _typing.reset();
    }
 
    void basic_text_box::select_start(int pos)
@@ -986,7 +1234,7 @@ namespace cycfi { namespace elements
    {
       bool r = basic_text_box::text(ctx, info);
       if (on_text)
-         on_text(get_text());
+         on_text(text_view{ _text });
       return r;
    }
 
@@ -998,7 +1246,7 @@ namespace cycfi { namespace elements
          {
             case key_code::enter:
                if (on_enter)
-                  on_enter(get_text());
+                  on_enter(text_view{ _text });
                ctx.view.refresh(ctx);
                ctx.view.end_focus();
                return true;
@@ -1058,13 +1306,13 @@ namespace cycfi { namespace elements
             ins += *p;
          }
 
-         _text.replace(start_, end_-start_, ins);
+         edit(start_, end_-start_, ins);
          start_ += ins.size();
          select_start(start_);
          select_end(start_);
 
          if (on_text)
-            on_text(_text);
+            on_text(text_view{ _text });
       }
    }
 
@@ -1072,7 +1320,7 @@ namespace cycfi { namespace elements
    {
       basic_text_box::delete_(forward);
       if (on_text)
-         on_text(_text);
+         on_text(text_view{ _text });
    }
 
    bool basic_input_box::click(context const& ctx, mouse_button btn)
@@ -6,6 +6,7 @@
 =============================================================================*/
 #include <elements/element/tile.hpp>
 #include <elements/support/context.hpp>
+#include <elements/view.hpp>
 
 #include <algorithm>
 #include <numeric>
@@ -97,20 +98,26 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    view_limits vtile_element::limits(basic_context const& ctx) const
    {
-      view_limits limits{ view_limits::init_side::max_x_max_y, full_extent<view_limits::coordinate_type>, 0.0 };
-      for (std::size_t i = 0; i != size();  ++i)
+      return cached_limits([&]
       {
-         auto el = at(i).limits(ctx);
-
-         limits.min.y += el.min.y;
-         limits.max.y += el.max.y;
-         clamp_min(limits.min.x, el.min.x);
-         clamp_max(limits.max.x, el.max.x);
-      }
+         view_limits limits{ view_limits::init_side::max_x_max_y, full_extent<view_limits::coordinate_type>, 0.0 };
+         for (std::size_t i = 0; i != size();  ++i)
+         {
+            auto const& e = at(i);
+            adopt(e);
+            ELEMENTS_TRACE_ZONE("limits", typeid(e));
+            auto el = e.limits(ctx);
+
+            limits.min.y += el.min.y;
+            limits.max.y += el.max.y;
+            clamp_min(limits.min.x, el.min.x);
+            clamp_max(limits.max.x, el.max.x);
+         }
 
-      clamp_min(limits.max.x, limits.min.x);
-      clamp_max(limits.max.y, full_extent<view_limits::coordinate_type>);
-      return limits;
+         clamp_min(limits.max.x, limits.min.x);
+         clamp_max(limits.max.y, full_extent<view_limits::coordinate_type>);
+         return limits;
+      });
    }
 
    void vtile_element::layout(context const& ctx)
@@ -150,14 +157,20 @@ namespace cycfi { namespace elements
 
          auto& elem = at(i);
          rect ebounds = { left, prev+top, right, curr+top };
+         ELEMENTS_TRACE_ZONE("layout", typeid(elem));
          elem.layout(context{ ctx, &elem, ebounds });
       }
    }
 
    void vtile_element::draw(context const& ctx)
    {
-      if (_tiles.empty())
-         layout(ctx);
+      ctx.view.exclusive(
+         [&]()
+         {
+            if (_tiles.empty())
+               layout(ctx);
+         }
+      );
       composite_base::draw(ctx);
    }
 
@@ -171,25 +184,43 @@ namespace cycfi { namespace elements
       return rect{ left, (index? _tiles[index-1] : 0)+top, right, _tiles[index]+top };
    }
 
+   composite_base::index_range vtile_element::hit_range(context const& ctx, point p) const
+   {
+      if (_tiles.size() != size())
+         return composite_base::hit_range(ctx, p);
+
+      // Tile i spans [_tiles[i-1], _tiles[i]). Find the first tile that
+      // ends below p.
+      auto i = std::upper_bound(_tiles.begin(), _tiles.end(), p.y - ctx.bounds.top);
+      std::size_t ix = i - _tiles.begin();
+      return { ix, std::min(ix+1, size()) };
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // Horizontal Tiles
    ////////////////////////////////////////////////////////////////////////////
    view_limits htile_element::limits(basic_context const& ctx) const
    {
-      view_limits limits{ view_limits::init_side::max_x_max_y, 0.0, full_extent<view_limits::coordinate_type> };
-      for (std::size_t i = 0; i != size();  ++i)
+      return cached_limits([&]
       {
-         auto el = at(i).limits(ctx);
-
-         limits.min.x += el.min.x;
-         limits.max.x += el.max.x;
-         clamp_min(limits.min.y, el.min.y);
-         clamp_max(limits.max.y, el.max.y);
-      }
+         view_limits limits{ view_limits::init_side::max_x_max_y, 0.0, full_extent<view_limits::coordinate_type> };
+         for (std::size_t i = 0; i != size();  ++i)
+         {
+            auto const& e = at(i);
+            adopt(e);
+            ELEMENTS_TRACE_ZONE("limits", typeid(e));
+            auto el = e.limits(ctx);
+
+            limits.min.x += el.min.x;
+            limits.max.x += el.max.x;
+            clamp_min(limits.min.y, el.min.y);
+            clamp_max(limits.max.y, el.max.y);
+         }
 
-      clamp_min(limits.max.y, limits.min.y);
-      clamp_max(limits.max.x, full_extent<view_limits::coordinate_type>);
-      return limits;
+         clamp_min(limits.max.y, limits.min.y);
+         clamp_max(limits.max.x, full_extent<view_limits::coordinate_type>);
+         return limits;
+      });
    }
 
    void htile_element::layout(context const& ctx)
@@ -229,14 +260,20 @@ namespace cycfi { namespace elements
 
          auto& elem = at(i);
          rect ebounds = { prev+left, top, curr+left, bottom };
+         ELEMENTS_TRACE_ZONE("layout", typeid(elem));
          elem.layout(context{ ctx, &elem, ebounds });
       }
    }
 
    void htile_element::draw(context const& ctx)
    {
-      if (_tiles.empty())
-         layout(ctx);
+      ctx.view.exclusive(
+         [&]()
+         {
+            if (_tiles.empty())
+               layout(ctx);
+         }
+      );
       composite_base::draw(ctx);
    }
 
@@ -249,4 +286,14 @@ namespace cycfi { namespace elements
       auto const left = ctx.bounds.left;
       return rect{ (index? _tiles[index-1] : 0)+left, top, _tiles[index]+left, bottom };
    }
+
+   composite_base::index_range htile_element::hit_range(context const& ctx, point p) const
+   {
+      if (_tiles.size() != size())
+         return composite_base::hit_range(ctx, p);
+
+      auto i = std::upper_bound(_tiles.begin(), _tiles.end(), p.x - ctx.bounds.left);
+      std::size_t ix = i - _tiles.begin();
+      return { ix, std::min(ix+1, size()) };
+   }
 }}
@@ -5,6 +5,7 @@
 =============================================================================*/
 #include <elements/support/canvas.hpp>
 #include <elements/support/enum_operator.hpp>
+#include <elements/support/text_cache.hpp>
 #include <cairo.h>
 
 #include <memory>
@@ -249,13 +250,10 @@ namespace cycfi::elements
 
 	namespace
 	{
-		point get_text_start(cairo_t& _context, point p, canvas::text_alignment align, const char * utf8)
+		point get_text_start(const text_cache::entry & text, point p, canvas::text_alignment align)
 		{
-			cairo_text_extents_t extents;
-			cairo_text_extents(&_context, utf8, &extents);
-
-			cairo_font_extents_t font_extents;
-			cairo_scaled_font_extents(cairo_get_scaled_font(&_context), &font_extents);
+			auto const& extents = text.extents;
+			auto const& font_extents = text.font_extents;
 
 			switch (canvas::text_alignment::horizontal_mask & align)
 			{
@@ -291,30 +289,36 @@ namespace cycfi::elements
 		}
 	}
 
+	// The glyph runs are shaped once, from the origin, and cached: the text
+	// is drawn by moving the origin to its start.
 	void canvas::fill_text(point p, char const* utf8)
 	{
 		apply_fill_style();
-		p = get_text_start(_context, p, _state.align, utf8);
-		cairo_move_to(&_context, p.x, p.y);
-		cairo_show_text(&_context, utf8);
+		auto text = text_cache::get().find(_context, utf8);
+		p = get_text_start(*text, p, _state.align);
+		cairo_save(&_context);
+		cairo_translate(&_context, p.x, p.y);
+		cairo_show_glyphs(&_context, text->glyphs.data(), int(text->glyphs.size()));
+		cairo_restore(&_context);
 	}
 
 	void canvas::stroke_text(point p, char const* utf8)
 	{
 		apply_stroke_style();
-		p = get_text_start(_context, p, _state.align, utf8);
-		cairo_move_to(&_context, p.x, p.y);
-		cairo_text_path(&_context, utf8);
+		auto text = text_cache::get().find(_context, utf8);
+		p = get_text_start(*text, p, _state.align);
+		cairo_save(&_context);
+		cairo_translate(&_context, p.x, p.y);
+		cairo_glyph_path(&_context, text->glyphs.data(), int(text->glyphs.size()));
+		cairo_restore(&_context);
 		stroke();
 	}
 
 	canvas::text_metrics canvas::measure_text(char const* utf8)
 	{
-		cairo_text_extents_t extents;
-		cairo_text_extents(&_context, utf8, &extents);
-
-		cairo_font_extents_t font_extents;
-		cairo_scaled_font_extents(cairo_get_scaled_font(&_context), &font_extents);
+		auto text = text_cache::get().find(_context, utf8);
+		auto const& extents = text->extents;
+		auto const& font_extents = text->font_extents;
 
 		return {
          /*ascent=*/    float(font_extents.ascent),
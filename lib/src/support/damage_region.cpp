@@ -0,0 +1,150 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/damage_region.hpp>
+#include <cmath>
+#include <utility>
+
+namespace cycfi::elements
+{
+	namespace
+	{
+		rect to_rect(const cairo_rectangle_int_t & r)
+		{
+			return {
+				static_cast<rect::coordinate_type>(r.x)
+			  , static_cast<rect::coordinate_type>(r.y)
+			  , static_cast<rect::coordinate_type>(r.x + r.width)
+			  , static_cast<rect::coordinate_type>(r.y + r.height)
+			};
+		}
+
+		bool to_cairo_rect(const rect & r, cairo_rectangle_int_t & cr)
+		{
+			auto left = static_cast<int>(std::floor(r.left));
+			auto top = static_cast<int>(std::floor(r.top));
+			auto right = static_cast<int>(std::ceil(r.right));
+			auto bottom = static_cast<int>(std::ceil(r.bottom));
+			if (right <= left || bottom <= top)
+				return false;
+			cr = { left, top, right - left, bottom - top };
+			return true;
+		}
+	}
+
+	damage_region::damage_region(std::size_t max_rects)
+		: _region(cairo_region_create())
+		, _max_rects(max_rects)
+	{}
+
+	damage_region::damage_region(const damage_region & rhs)
+		: _region(cairo_region_copy(rhs._region))
+		, _max_rects(rhs._max_rects)
+	{}
+
+	damage_region& damage_region::operator=(const damage_region & rhs)
+	{
+		if (this != &rhs)
+		{
+			damage_region copy{ rhs };
+			swap(copy);
+		}
+		return *this;
+	}
+
+	damage_region::~damage_region()
+	{
+		cairo_region_destroy(_region);
+	}
+
+	void damage_region::add(const rect & r)
+	{
+		cairo_rectangle_int_t cr;
+		if (to_cairo_rect(r, cr))
+		{
+			cairo_region_union_rectangle(_region, &cr);
+			limit();
+		}
+	}
+
+	void damage_region::add(const damage_region & other)
+	{
+		cairo_region_union(_region, other._region);
+		limit();
+	}
+
+	void damage_region::clear()
+	{
+		cairo_region_destroy(_region);
+		_region = cairo_region_create();
+	}
+
+	void damage_region::swap(damage_region & other)
+	{
+		std::swap(_region, other._region);
+		std::swap(_max_rects, other._max_rects);
+	}
+
+	bool damage_region::empty() const
+	{
+		return cairo_region_is_empty(_region);
+	}
+
+	std::size_t damage_region::size() const
+	{
+		return cairo_region_num_rectangles(_region);
+	}
+
+	rect damage_region::operator[](std::size_t i) const
+	{
+		cairo_rectangle_int_t r;
+		cairo_region_get_rectangle(_region, int(i), &r);
+		return to_rect(r);
+	}
+
+	rect damage_region::extents() const
+	{
+		cairo_rectangle_int_t r;
+		cairo_region_get_extents(_region, &r);
+		return to_rect(r);
+	}
+
+	float damage_region::area() const
+	{
+		float total = 0;
+		for (int i = 0, n = cairo_region_num_rectangles(_region); i != n; ++i)
+		{
+			cairo_rectangle_int_t r;
+			cairo_region_get_rectangle(_region, i, &r);
+			total += float(r.width) * r.height;
+		}
+		return total;
+	}
+
+	bool damage_region::intersects(const rect & r) const
+	{
+		cairo_rectangle_int_t cr;
+		if (!to_cairo_rect(r, cr))
+			return false;
+		return cairo_region_contains_rectangle(_region, &cr) != CAIRO_REGION_OVERLAP_OUT;
+	}
+
+	void damage_region::max_rects(std::size_t n)
+	{
+		_max_rects = n;
+		limit();
+	}
+
+	void damage_region::limit()
+	{
+		if (std::size_t(cairo_region_num_rectangles(_region)) > _max_rects)
+		{
+			cairo_rectangle_int_t r;
+			cairo_region_get_extents(_region, &r);
+			cairo_region_destroy(_region);
+			_region = cairo_region_create_rectangle(&r);
+		}
+	}
+}
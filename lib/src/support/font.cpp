@@ -7,6 +7,7 @@
 =============================================================================*/
 #include <elements/support/font.hpp>
 #include <elements/support/enum_operator.hpp>
+#include <elements/support/trace.hpp>
 #include <infra/assert.hpp>
 
 #include <cairo.h>
@@ -624,6 +625,8 @@ namespace cycfi::elements
 
 	font::font(font_descriptor descriptor)
 	{
+		ELEMENTS_TRACE_ZONE("font", "font::font");
+
 #ifndef __APPLE__
 		static free_type_library ft_lib;
 #endif
@@ -5,6 +5,7 @@
 =============================================================================*/
 #include <elements/support/glyphs.hpp>
 #include <elements/support/detail/scratch_context.hpp>
+#include <elements/support/trace.hpp>
 
 namespace cycfi { namespace elements
 {
@@ -33,6 +34,8 @@ namespace cycfi { namespace elements
     , _clusters(master._clusters + cluster_start)
     , _cluster_count(cluster_end - cluster_start)
     , _clusterflags(master._clusterflags)
+    , _advances(master._advances + glyph_start)
+    , _cluster_info(master._cluster_info + cluster_start)
    {
       CYCFI_ASSERT(_first, "Precondition failure: _first must not be null");
       CYCFI_ASSERT(_last, "Precondition failure: _last must not be null");
@@ -69,8 +72,10 @@ namespace cycfi { namespace elements
 
          _glyph_count -= glyph_index;
          _glyphs += glyph_index;
+         _advances += glyph_index;
          _cluster_count -= clusters_skipped;
          _clusters = cluster;
+         _cluster_info += clusters_skipped;
          _first += clusters_skipped;
       };
 
@@ -114,10 +119,8 @@ namespace cycfi { namespace elements
 
       if (_glyph_count)
       {
-         cairo_text_extents_t extents;
          auto glyph = _glyphs + _glyph_count -1;
-         cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
-         return (glyph->x + extents.x_advance) - _glyphs->x;
+         return (glyph->x + _advances[_glyph_count-1]) - _glyphs->x;
       }
       return 0;
    }
@@ -164,6 +167,8 @@ namespace cycfi { namespace elements
 
    master_glyphs::master_glyphs(master_glyphs&& rhs)
     : glyphs(rhs._first, rhs._last)
+    , _advance_data(std::move(rhs._advance_data))
+    , _cluster_data(std::move(rhs._cluster_data))
    {
       _scaled_font = rhs._scaled_font;
       _glyphs = rhs._glyphs;
@@ -171,6 +176,8 @@ namespace cycfi { namespace elements
       _clusters = rhs._clusters;
       _cluster_count = rhs._cluster_count;
       _clusterflags = rhs._clusterflags;
+      _advances = _advance_data.data();
+      _cluster_info = _cluster_data.data();
 
       rhs._glyphs = nullptr;
       rhs._clusters = nullptr;
@@ -189,6 +196,10 @@ namespace cycfi { namespace elements
          _clusters = rhs._clusters;
          _cluster_count = rhs._cluster_count;
          _clusterflags = rhs._clusterflags;
+         _advance_data = std::move(rhs._advance_data);
+         _cluster_data = std::move(rhs._cluster_data);
+         _advances = _advance_data.data();
+         _cluster_info = _cluster_data.data();
 
          rhs._glyphs = nullptr;
          rhs._clusters = nullptr;
@@ -231,6 +242,8 @@ namespace cycfi { namespace elements
 
    void master_glyphs::break_lines(float width, std::vector<glyphs>& lines)
    {
+      ELEMENTS_TRACE_ZONE("text", "master_glyphs::break_lines");
+
       CYCFI_ASSERT(_scaled_font, "Precondition failure: _scaled_font must not be null");
 
       // reurn early if there's nothing to break
@@ -277,9 +290,7 @@ namespace cycfi { namespace elements
             cairo_glyph_t*  glyph = _glyphs + glyph_index;
 
             // Check if we exceeded the line width:
-            cairo_text_extents_t extents;
-            cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
-            if (((glyph->x + extents.x_advance) - start_x) > width)
+            if (((glyph->x + _advances[glyph_index]) - start_x) > width)
             {
                // Add the line if we did (exceed the line width)
                add_line();
@@ -316,6 +327,13 @@ namespace cycfi { namespace elements
 
    void master_glyphs::build(point start)
    {
+      ELEMENTS_TRACE_ZONE("text", "master_glyphs::build");
+
+      _advance_data.clear();
+      _cluster_data.clear();
+      _advances = nullptr;
+      _cluster_info = nullptr;
+
       // reurn early if there's nothing to build
       if (_first == _last)
          return;
@@ -331,5 +349,30 @@ namespace cycfi { namespace elements
          _clusters = nullptr;
          throw failed_to_build_master_glyphs{};
       }
+
+      // Measure the glyphs once, for width(), break_lines() and the
+      // cluster queries
+      _advance_data.resize(_glyph_count);
+      for (int i = 0; i < _glyph_count; ++i)
+      {
+         cairo_text_extents_t extents;
+         cairo_scaled_font_glyph_extents(_scaled_font, _glyphs + i, 1, &extents);
+         _advance_data[i] = float(extents.x_advance);
+      }
+
+      _cluster_data.resize(_cluster_count);
+      int glyph_index = 0;
+      int byte_index = 0;
+      for (int i = 0; i < _cluster_count; ++i)
+      {
+         float left = glyph_index < _glyph_count? float(_glyphs[glyph_index].x) : 0;
+         float advance = glyph_index < _glyph_count? _advance_data[glyph_index] : 0;
+         _cluster_data[i] = { left, left + advance, byte_index };
+         glyph_index += _clusters[i].num_glyphs;
+         byte_index += _clusters[i].num_bytes;
+      }
+
+      _advances = _advance_data.data();
+      _cluster_info = _cluster_data.data();
    }
 }}
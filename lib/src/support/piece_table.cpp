@@ -0,0 +1,323 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/piece_table.hpp>
+#include <algorithm>
+#include <utility>
+
+namespace cycfi::elements
+{
+	namespace
+	{
+		char const no_text[] = "";
+	}
+
+	piece_table::piece_table(std::string text)
+	{
+		assign(text);
+		_flat_valid = text.empty();
+	}
+
+	char piece_table::operator[](std::size_t pos) const
+	{
+		auto t = _root.get();
+		while (t)
+		{
+			auto left_size = size_of(t->left);
+			if (pos < left_size)
+			{
+				t = t->left.get();
+			}
+			else if (pos < left_size + t->p.length)
+			{
+				return text_of(t->p)[pos - left_size];
+			}
+			else
+			{
+				pos -= left_size + t->p.length;
+				t = t->right.get();
+			}
+		}
+		return 0;
+	}
+
+	std::string piece_table::substr(std::size_t pos, std::size_t n) const
+	{
+		std::string result;
+		auto end = std::min(size(), pos + std::min(n, size()));
+		if (pos < end)
+		{
+			result.reserve(end - pos);
+			append_to(result, _root.get(), pos, end);
+		}
+		return result;
+	}
+
+	const std::string & piece_table::str() const
+	{
+		if (!_flat_valid)
+		{
+			_flat.clear();
+			_flat.reserve(size());
+			append_to(_flat, _root.get(), 0, size());
+			_flat_valid = true;
+		}
+		return _flat;
+	}
+
+	void piece_table::assign(string_view text)
+	{
+		auto original = make_chunk(text.size());
+		std::copy(text.begin(), text.end(), original.data.get());
+		original.size = text.size();
+		reset(std::move(original));
+		_flat_valid = false;
+	}
+
+	void piece_table::reset(chunk original)
+	{
+		_original = std::move(original);
+		_added.clear();
+		_stored = _original.size;
+		_root.reset();
+		if (_original.size)
+			_root = make_node({ 0, 0, _original.size });
+	}
+
+	void piece_table::insert(std::size_t pos, string_view text)
+	{
+		if (text.empty())
+			return;
+
+		node_ptr l, r;
+		split(std::move(_root), std::min(pos, size()), l, r);
+		if (!extend(l.get(), text))
+		{
+			l = merge(std::move(l), make_node(add(text)));
+		}
+		_root = merge(std::move(l), std::move(r));
+		_flat_valid = false;
+	}
+
+	void piece_table::erase(std::size_t pos, std::size_t n)
+	{
+		if (n == 0 || pos >= size())
+			return;
+
+		node_ptr l, m, r;
+		split(std::move(_root), pos, l, m);
+		split(std::move(m), n, m, r);
+		_root = merge(std::move(l), std::move(r));
+		_flat_valid = false;
+	}
+
+	void piece_table::replace(std::size_t pos, std::size_t n, string_view text)
+	{
+		erase(pos, n);
+		insert(pos, text);
+	}
+
+	string_view piece_table::contiguous(std::size_t pos, std::size_t n)
+	{
+		pos = std::min(pos, size());
+		n = std::min(n, size() - pos);
+		if (n == 0)
+			return { no_text, 0 };
+
+		node_ptr l, m, r;
+		split(std::move(_root), pos, l, m);
+		split(std::move(m), n, m, r);
+		if (m->left || m->right)
+		{
+			// More than one piece: replace them with a copy of their text
+			std::string text;
+			text.reserve(n);
+			append_to(text, m.get(), 0, n);
+			m = make_node(add(text));
+		}
+		auto result = text_of(m->p);
+		_root = merge(merge(std::move(l), std::move(m)), std::move(r));
+		return result;
+	}
+
+	void piece_table::compact()
+	{
+		auto original = make_chunk(size());
+		for_each_piece(
+			[&](string_view piece)
+			{
+				std::copy(piece.begin(), piece.end(), original.data.get() + original.size);
+				original.size += piece.size();
+			}
+		);
+		reset(std::move(original));
+	}
+
+	piece_table::chunk piece_table::make_chunk(std::size_t capacity)
+	{
+		if (capacity == 0)
+			return {};
+		return { std::unique_ptr<char[]>{ new char[capacity] }, 0, capacity };
+	}
+
+	void piece_table::update(node& t)
+	{
+		t.size = size_of(t.left) + t.p.length + size_of(t.right);
+	}
+
+	piece_table::node_ptr piece_table::merge(node_ptr l, node_ptr r)
+	{
+		if (!l)
+			return r;
+		if (!r)
+			return l;
+		if (l->priority > r->priority)
+		{
+			l->right = merge(std::move(l->right), std::move(r));
+			update(*l);
+			return l;
+		}
+		r->left = merge(std::move(l), std::move(r->left));
+		update(*r);
+		return r;
+	}
+
+	piece_table::node_ptr piece_table::make_node(piece p)
+	{
+		// xorshift32
+		_seed ^= _seed << 13;
+		_seed ^= _seed >> 17;
+		_seed ^= _seed << 5;
+		return node_ptr{ new node{ p, _seed, p.length, nullptr, nullptr } };
+	}
+
+	piece_table::piece piece_table::add(string_view text)
+	{
+		// Append text to the added text, in a new chunk if it does not fit
+		// in the last one. The chunks are never reallocated.
+		if (_added.empty() || _added.back().capacity - _added.back().size < text.size())
+		{
+			_added.push_back(make_chunk(std::max(min_chunk_size, text.size())));
+		}
+
+		auto& c = _added.back();
+		std::copy(text.begin(), text.end(), c.data.get() + c.size);
+		piece p{ std::uint32_t(_added.size()), c.size, text.size() };
+		c.size += text.size();
+		_stored += text.size();
+		return p;
+	}
+
+	void piece_table::split(node_ptr t, std::size_t pos, node_ptr& l, node_ptr& r)
+	{
+		// l gets the first pos characters of t, r gets the rest
+		if (!t)
+		{
+			l.reset();
+			r.reset();
+			return;
+		}
+
+		auto left_size = size_of(t->left);
+		if (pos <= left_size)
+		{
+			split(std::move(t->left), pos, l, t->left);
+			update(*t);
+			r = std::move(t);
+		}
+		else if (pos >= left_size + t->p.length)
+		{
+			split(std::move(t->right), pos - left_size - t->p.length, t->right, r);
+			update(*t);
+			l = std::move(t);
+		}
+		else
+		{
+			// pos is inside this piece: split the piece
+			auto offset = pos - left_size;
+			auto rest = make_node({ t->p.buffer, t->p.start + offset, t->p.length - offset });
+			t->p.length = offset;
+			r = merge(std::move(rest), std::move(t->right));
+			update(*t);
+			l = std::move(t);
+		}
+	}
+
+	bool piece_table::extend(node* t, string_view text)
+	{
+		// Append text to the last piece of t, if it is the end of the last
+		// chunk of the added text, and the text fits in the chunk
+		if (!t)
+			return false;
+
+		bool extended = false;
+		if (t->right)
+		{
+			extended = extend(t->right.get(), text);
+		}
+		else if (!_added.empty() && t->p.buffer == _added.size())
+		{
+			auto& c = _added.back();
+			if (t->p.start + t->p.length == c.size && c.capacity - c.size >= text.size())
+			{
+				std::copy(text.begin(), text.end(), c.data.get() + c.size);
+				c.size += text.size();
+				_stored += text.size();
+				t->p.length += text.size();
+				extended = true;
+			}
+		}
+
+		if (extended)
+			t->size += text.size();
+		return extended;
+	}
+
+	void piece_table::append_to(std::string& out, const node* t, std::size_t pos, std::size_t end) const
+	{
+		// Append the text in [pos, end) of the subtree t
+		if (!t || pos >= end)
+			return;
+
+		auto left_size = size_of(t->left);
+		auto right_start = left_size + t->p.length;
+		if (pos < left_size)
+			append_to(out, t->left.get(), pos, std::min(end, left_size));
+
+		auto first = std::max(pos, left_size);
+		auto last = std::min(end, right_start);
+		if (first < last)
+		{
+			auto text = text_of(t->p).substr(first - left_size, last - first);
+			out.append(text.data(), text.size());
+		}
+
+		if (end > right_start)
+			append_to(out, t->right.get(), pos > right_start? pos - right_start : 0, end - right_start);
+	}
+
+	string_view piece_table::text_of(const piece & p) const
+	{
+		auto data = p.buffer? _added[p.buffer-1].data.get() : _original.data.get();
+		return string_view{ data + p.start, p.length };
+	}
+
+	bool operator==(text_view a, string_view b)
+	{
+		if (a.size() != b.size())
+			return false;
+
+		bool equal = true;
+		a.for_each_piece(
+			[&](string_view piece)
+			{
+				if (equal)
+					equal = piece == b.substr(0, piece.size());
+				b.remove_prefix(piece.size());
+			}
+		);
+		return equal;
+	}
+}
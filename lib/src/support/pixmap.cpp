@@ -5,6 +5,7 @@
 =============================================================================*/
 #include <elements/support/pixmap.hpp>
 #include <elements/support/resource_paths.hpp>
+#include <elements/support/trace.hpp>
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_NO_PNG 1
 #include <elements/support/detail/stb_image.h>
@@ -14,21 +15,11 @@
 
 namespace cycfi::elements
 {
-	template<typename T, typename>
-	pixmap::pixmap(size_type width, size_type height, T scale)
-		: surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height))
-	{
-		if (!surface)
-			throw failed_to_load_pixmap{ "Failed to create pixmap." };
-
-		// Set scale and flag the surface as dirty
-		cairo_surface_set_device_scale(surface, static_cast<double>(1)/scale, static_cast<double>(1)/scale);
-		cairo_surface_mark_dirty(surface);
-   }
-
    pixmap::pixmap(const char* filename, float scale)
 	   : surface(nullptr)
    {
+	   ELEMENTS_TRACE_ZONE("image", "pixmap::pixmap");
+
 	   auto  path = std::string(filename);
 	   auto  pos = path.find_last_of('.');
 	   if (pos == std::string::npos)
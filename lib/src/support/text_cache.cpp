@@ -0,0 +1,135 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/text_cache.hpp>
+#include <functional>
+
+namespace cycfi::elements
+{
+	namespace
+	{
+		text_cache::entry shape(cairo_scaled_font_t* font, string_view text)
+		{
+			text_cache::entry result;
+			cairo_scaled_font_extents(font, &result.font_extents);
+			if (text.empty())
+				return result;
+
+			cairo_glyph_t* glyphs = nullptr;
+			int num_glyphs = 0;
+			auto status = cairo_scaled_font_text_to_glyphs(
+				font, 0, 0, text.data(), int(text.size())
+			  , &glyphs, &num_glyphs, nullptr, nullptr, nullptr
+			);
+
+			if (status == CAIRO_STATUS_SUCCESS)
+			{
+				result.glyphs.assign(glyphs, glyphs + num_glyphs);
+				cairo_scaled_font_glyph_extents(font, glyphs, num_glyphs, &result.extents);
+			}
+			cairo_glyph_free(glyphs);
+			return result;
+		}
+	}
+
+	text_cache::text_cache(std::size_t capacity)
+		: _capacity(capacity)
+	{}
+
+	text_cache::~text_cache()
+	{
+		clear();
+	}
+
+	text_cache& text_cache::get()
+	{
+		static text_cache cache;
+		return cache;
+	}
+
+	std::size_t text_cache::key_hash::operator()(const key_type & key) const
+	{
+		auto h = std::hash<string_view>{}(key.second);
+		return h ^ (std::hash<void*>{}(key.first) + 0x9e3779b9 + (h << 6) + (h >> 2));
+	}
+
+	text_cache::entry_ptr text_cache::find(cairo_t& context, const char * utf8)
+	{
+		auto* font = cairo_get_scaled_font(&context);
+		string_view text = utf8? utf8 : "";
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (auto i = _map.find({ font, text }); i != _map.end())
+			{
+				++_stats.hits;
+				_nodes.splice(_nodes.begin(), _nodes, i->second);
+				return i->second->shaped;
+			}
+			++_stats.misses;
+		}
+
+		// Shape outside the lock. If another thread shaped the same text in
+		// the meantime, keep theirs.
+		auto shaped = std::make_shared<const entry>(shape(font, text));
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (auto i = _map.find({ font, text }); i != _map.end())
+			return i->second->shaped;
+		if (_capacity == 0)
+			return shaped;
+
+		evict(_capacity - 1);
+
+		// Hold a reference to the font, so that it is not destroyed, and its
+		// address reused, while it is used as a key
+		_nodes.push_front({ cairo_scaled_font_reference(font), std::string{ text }, shaped });
+		auto& n = _nodes.front();
+		_map.emplace(key_type{ n.font, n.text }, _nodes.begin());
+		return shaped;
+	}
+
+	void text_cache::evict(std::size_t n)
+	{
+		while (_nodes.size() > n)
+		{
+			auto& last = _nodes.back();
+			_map.erase({ last.font, last.text });
+			cairo_scaled_font_destroy(last.font);
+			_nodes.pop_back();
+		}
+	}
+
+	text_cache::cache_stats text_cache::stats() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _stats;
+	}
+
+	void text_cache::reset_stats()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stats = {};
+	}
+
+	void text_cache::clear()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		evict(0);
+	}
+
+	std::size_t text_cache::capacity() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _capacity;
+	}
+
+	void text_cache::capacity(std::size_t n)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_capacity = n;
+		evict(n);
+	}
+}
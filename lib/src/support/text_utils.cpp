@@ -6,6 +6,7 @@
 #include <elements/support/text_utils.hpp>
 #include <elements/support/theme.hpp>
 #include <elements/support/enum_operator.hpp>
+#include <infra/utf8_utils.hpp>
 
 namespace cycfi { namespace elements
 {
@@ -18,7 +19,8 @@ namespace cycfi { namespace elements
       cnv.font(thm.icon_font, size);
       cnv.fill_style(c);
       cnv.text_align(canvas::text_alignment::middle | canvas::text_alignment::center);
-      cnv.fill_text(point{ cx, cy }, codepoint_to_utf8(code).c_str());
+      char utf8[8];
+      cnv.fill_text(point{ cx, cy }, cycfi::detail::codepoint_to_utf8(code, utf8));
    }
 
    void draw_icon(canvas& cnv, rect bounds, uint32_t code, float size)
@@ -31,7 +33,8 @@ namespace cycfi { namespace elements
       auto  state = cnv.new_state();
       auto& thm = get_theme();
       cnv.font(thm.icon_font, size);
-      return cnv.measure_text(codepoint_to_utf8(cp).c_str()).size;
+      char utf8[8];
+      return cnv.measure_text(cycfi::detail::codepoint_to_utf8(cp, utf8)).size;
    }
 
    point measure_text(canvas& cnv, char const* text, font const& font_, float size)
@@ -43,36 +46,10 @@ namespace cycfi { namespace elements
       return { info.size.x, height };
    }
 
-   namespace detail
-   {
-      char const* codepoint_to_utf8(unsigned cp, char str[8])
-      {
-         size_t n = 0;
-         if (cp < 0x80) n = 1;
-         else if (cp < 0x800) n = 2;
-         else if (cp < 0x10000) n = 3;
-         else if (cp < 0x200000) n = 4;
-         else if (cp < 0x4000000) n = 5;
-         else if (cp <= 0x7fffffff) n = 6;
-         str[n] = '\0';
-
-         switch (n)
-         {
-            case 6: str[5] = 0x80 | (cp & 0x3f); cp = cp >> 6; cp |= 0x4000000; [[fallthrough]];
-            case 5: str[4] = 0x80 | (cp & 0x3f); cp = cp >> 6; cp |= 0x200000;  [[fallthrough]];
-            case 4: str[3] = 0x80 | (cp & 0x3f); cp = cp >> 6; cp |= 0x10000;   [[fallthrough]];
-            case 3: str[2] = 0x80 | (cp & 0x3f); cp = cp >> 6; cp |= 0x800;     [[fallthrough]];
-            case 2: str[1] = 0x80 | (cp & 0x3f); cp = cp >> 6; cp |= 0xc0;      [[fallthrough]];
-            case 1: str[0] = cp;
-         }
-         return str;
-      }
-   }
-
    std::string codepoint_to_utf8(unsigned codepoint)
    {
       char result[8];
-      detail::codepoint_to_utf8(codepoint, &result[0]);
+      cycfi::detail::codepoint_to_utf8(codepoint, &result[0]);
       return { result };
    }
 }}
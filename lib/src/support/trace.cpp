@@ -0,0 +1,221 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/trace.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <ios>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__GNUG__)
+# include <cxxabi.h>
+#endif
+
+namespace cycfi::elements::trace
+{
+	namespace detail
+	{
+		std::atomic<bool> enabled{ false };
+	}
+
+	namespace
+	{
+		// The fields are atomic so that dump() can read them while the
+		// thread writes them, without a data race. Relaxed atomic loads and
+		// stores are plain loads and stores on the common targets.
+		struct slot
+		{
+			std::atomic<const char*> name;
+			std::atomic<const char*> category;
+			std::atomic<std::int64_t> begin;
+			std::atomic<std::int64_t> end;
+			std::atomic<bool> type_name;
+		};
+
+		// Written by its thread only, as a sequence lock: `started` is
+		// incremented before an event is written, and `written` after. The
+		// reader takes the events below `written`, then discards those that
+		// the thread started to overwrite while it read.
+		struct ring
+		{
+			std::array<slot, ring_size> events;
+			std::atomic<std::uint64_t> started{ 0 };
+			std::atomic<std::uint64_t> written{ 0 };
+			std::atomic<std::uint64_t> cleared{ 0 };
+			int tid;
+		};
+
+		using ring_ptr = std::shared_ptr<ring>;
+
+		// The rings outlive their threads, so that their events can still
+		// be dumped.
+		struct registry
+		{
+			std::mutex mutex;
+			std::vector<ring_ptr> rings;
+		};
+
+		registry& get_registry()
+		{
+			static registry reg;
+			return reg;
+		}
+
+		ring& this_thread_ring()
+		{
+			thread_local ring_ptr r = []
+			{
+				auto& reg = get_registry();
+				std::lock_guard<std::mutex> lock(reg.mutex);
+				auto p = std::make_shared<ring>();
+				p->tid = int(reg.rings.size()) + 1;
+				reg.rings.push_back(p);
+				return p;
+			}();
+			return *r;
+		}
+
+		clock::time_point epoch()
+		{
+			static auto const start = clock::now();
+			return start;
+		}
+
+		std::string demangle(const char* name)
+		{
+#if defined(__GNUG__)
+			int status = 0;
+			char* s = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+			if (status == 0 && s)
+			{
+				std::string result = s;
+				std::free(s);
+				return result;
+			}
+#endif
+			return name;
+		}
+
+		void write_string(std::ostream& out, const std::string & s)
+		{
+			out << '"';
+			for (char c : s)
+			{
+				if (c == '"' || c == '\\')
+					out << '\\' << c;
+				else if (static_cast<unsigned char>(c) < 0x20)
+					out << ' ';
+				else
+					out << c;
+			}
+			out << '"';
+		}
+	}
+
+	void enable(bool enable_)
+	{
+		epoch();
+		detail::enabled.store(enable_, std::memory_order_relaxed);
+	}
+
+	std::int64_t now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - epoch()).count();
+	}
+
+	void record(const event & ev)
+	{
+		auto& r = this_thread_ring();
+		auto n = r.written.load(std::memory_order_relaxed);
+		r.started.store(n + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		auto& s = r.events[n % ring_size];
+		s.name.store(ev.name, std::memory_order_relaxed);
+		s.category.store(ev.category, std::memory_order_relaxed);
+		s.begin.store(ev.begin, std::memory_order_relaxed);
+		s.end.store(ev.end, std::memory_order_relaxed);
+		s.type_name.store(ev.type_name, std::memory_order_relaxed);
+		r.written.store(n + 1, std::memory_order_release);
+	}
+
+	void clear()
+	{
+		auto& reg = get_registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		for (auto& r : reg.rings)
+			r->cleared.store(r->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+	}
+
+	void dump(std::ostream& out)
+	{
+		std::vector<ring_ptr> rings;
+		{
+			auto& reg = get_registry();
+			std::lock_guard<std::mutex> lock(reg.mutex);
+			rings = reg.rings;
+		}
+
+		auto flags = out.flags();
+		auto precision = out.precision();
+		out << std::fixed;
+		out.precision(3);
+
+		out << "{\"traceEvents\":[";
+		bool first = true;
+		for (auto const& r : rings)
+		{
+			auto last = r->written.load(std::memory_order_acquire);
+			auto begin = std::max(r->cleared.load(std::memory_order_relaxed), last > ring_size? last - ring_size : 0);
+
+			std::vector<event> events;
+			events.reserve(last - begin);
+			for (auto i = begin; i != last; ++i)
+			{
+				auto const& s = r->events[i % ring_size];
+				events.push_back({
+					s.name.load(std::memory_order_relaxed)
+				 , s.category.load(std::memory_order_relaxed)
+				 , s.begin.load(std::memory_order_relaxed)
+				 , s.end.load(std::memory_order_relaxed)
+				 , s.type_name.load(std::memory_order_relaxed)
+				});
+			}
+
+			// Drop the events that the thread started to overwrite while we
+			// copied them: event number started - 1 is in the slot of event
+			// started - 1 - ring_size, and the ones before it were done.
+			std::atomic_thread_fence(std::memory_order_acquire);
+			auto started = r->started.load(std::memory_order_relaxed);
+			auto first_intact = started > ring_size? started - ring_size : 0;
+			std::size_t skip = 0;
+			if (first_intact > begin)
+				skip = std::min<std::size_t>(first_intact - begin, events.size());
+
+			for (std::size_t i = skip; i != events.size(); ++i)
+			{
+				auto const& ev = events[i];
+				out << (first? "\n" : ",\n");
+				first = false;
+				out << "{\"name\":";
+				write_string(out, ev.type_name? demangle(ev.name) : ev.name);
+				out << ",\"cat\":";
+				write_string(out, ev.category);
+				out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << r->tid
+					<< ",\"ts\":" << (ev.begin / 1000.0)
+					<< ",\"dur\":" << ((ev.end - ev.begin) / 1000.0)
+					<< '}';
+			}
+		}
+		out << "\n]}\n";
+		out.flags(flags);
+		out.precision(precision);
+	}
+}
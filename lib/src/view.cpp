@@ -4,11 +4,105 @@
    Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
 =============================================================================*/
 #include <elements/view.hpp>
+#include <elements/element/retained.hpp>
 #include <elements/window.hpp>
 #include <elements/support/context.hpp>
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <set>
+#include <thread>
+#include <utility>
 
  namespace cycfi { namespace elements
  {
+   ////////////////////////////////////////////////////////////////////////////
+   // Tiled rendering workers
+   ////////////////////////////////////////////////////////////////////////////
+   struct view::draw_workers
+   {
+      explicit draw_workers(std::size_t n)
+      {
+         for (std::size_t i = 0; i != n; ++i)
+            threads.emplace_back([this]() { work(); });
+      }
+
+      ~draw_workers()
+      {
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+         }
+         cv.notify_all();
+         for (auto& t : threads)
+            t.join();
+      }
+
+      // Runs all the jobs, on the workers and on the calling thread, and
+      // returns when they are all done.
+      void run(std::vector<std::function<void()>>& jobs_)
+      {
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& job : jobs_)
+               jobs.push_back(std::move(job));
+            pending += jobs_.size();
+         }
+         cv.notify_all();
+
+         while (run_one())
+            ;
+
+         std::unique_lock<std::mutex> lock(mutex);
+         done_cv.wait(lock, [this]() { return pending == 0; });
+      }
+
+      bool run_one()
+      {
+         std::function<void()> job;
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (jobs.empty())
+               return false;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+         }
+         job();
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0)
+               done_cv.notify_all();
+         }
+         return true;
+      }
+
+      void work()
+      {
+         while (true)
+         {
+            {
+               std::unique_lock<std::mutex> lock(mutex);
+               cv.wait(lock, [this]() { return stop || !jobs.empty(); });
+               if (stop)
+                  return;
+            }
+            run_one();
+         }
+      }
+
+      std::vector<std::thread> threads;
+      std::deque<std::function<void()>> jobs;
+      std::size_t pending = 0;
+      bool stop = false;
+      std::mutex mutex;
+      std::condition_variable cv;
+      std::condition_variable done_cv;
+   };
+
+   // Where the current thread reports what it draws
+   thread_local view::draw_scope* view::current_scope = nullptr;
+
    view::view(extent size_)
     : base_view(size_)
     , _main_element(make_scaled_content())
@@ -38,28 +132,28 @@
       _io.stop();
    }
 
+
    void view::set_limits()
    {
       if (_content.empty())
          return;
 
-      auto surface_ = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
-      auto context_ = cairo_create(surface_);
-      canvas cnv{ *context_ };
-      cnv.pre_scale(hdpi_scale());
+      ELEMENTS_TRACE_ZONE("limits", "view::set_limits");
+      _measure.save();
+      cairo_identity_matrix(&_measure.cairo_context());
+      _measure.pre_scale(hdpi_scale());
 
       // Update the limits and constrain the window size to the limits
-      basic_context bctx{ *this, cnv };
+      basic_context bctx{ *this, _measure };
       auto limits_ = _main_element.limits(bctx);
+      _measure.restore();
+
       if (limits_.min != _current_limits.min || limits_.max != _current_limits.max)
       {
          _current_limits = limits_;
          if (on_change_limits)
             on_change_limits(limits_);
       }
-
-      cairo_surface_destroy(surface_);
-      cairo_destroy(context_);
    }
 
    void view::draw(cairo_t* context_, rect dirty_)
@@ -67,44 +161,136 @@
       if (_content.empty())
          return;
 
+      ELEMENTS_TRACE_ZONE("draw", "view::draw");
+      using clock = std::chrono::steady_clock;
       _dirty = dirty_;
+      _draw_damage.swap(_frame_damage);
+      _frame_damage.clear();
+      _frame = {};
+      auto dpi = hdpi_scale();
+      _frame.damaged_area = dirty_.width() * dirty_.height() * dpi * dpi;
+      _frame.pending_posts = _pending_posts;
+
+      // A full refresh draws everything that is visible: forget where the
+      // elements that are gone, or no longer visible, were drawn.
+      auto size_ = size();
+      rect subj_bounds = { 0, 0, size_.width, size_.height };
+      if (dirty_.left <= subj_bounds.left && dirty_.top <= subj_bounds.top
+         && dirty_.right >= subj_bounds.right && dirty_.bottom >= subj_bounds.bottom)
+         _drawn.clear();
+      ++_draw_count;
 
       // Update the limits and constrain the window size to the limits
+      auto start = clock::now();
       set_limits();
+      auto limits_done = clock::now();
 
       canvas cnv{ *context_ };
-      cnv.pre_scale(hdpi_scale());
-      auto size_ = size();
-      rect subj_bounds = { 0, 0, size_.width, size_.height };
+      cnv.pre_scale(dpi);
       context ctx{ *this, cnv, &_main_element, subj_bounds };
 
       // layout the subject only if the window bounds changes
       if (subj_bounds != _current_bounds)
       {
+         ELEMENTS_TRACE_ZONE("layout", "view::layout");
          _current_bounds = subj_bounds;
+         _last_hit_depth = 0;
          _main_element.layout(ctx);
       }
+      auto layout_done = clock::now();
 
-      // draw the subject
-      _main_element.draw(ctx);
+      // draw the subject, in tiles if enabled and worth it
+      if (_draw_threads < 2 || !draw_tiles(context_, subj_bounds))
+      {
+         draw_scope scope;
+         scope.cnv = &cnv;
+         current_scope = &scope;
+         _main_element.draw(ctx);
+         current_scope = nullptr;
+         merge(scope);
+      }
+      auto draw_done = clock::now();
+
+      _frame.limits_time = limits_done - start;
+      _frame.layout_time = layout_done - limits_done;
+      _frame.draw_time = draw_done - layout_done;
+      _frame_history.limits_time.add(_frame.limits_time);
+      _frame_history.layout_time.add(_frame.layout_time);
+      _frame_history.draw_time.add(_frame.draw_time);
+      _frame_history.total_time.add(draw_done - start);
+
+      if (on_frame)
+         on_frame(_frame);
+   }
+
+   template <typename F>
+   void view::call(F f)
+   {
+      // The measuring canvas is reused: save and restore around each call
+      // so that state set by elements does not leak into the next one.
+      _measure.save();
+      _measure.begin_path();
+      cairo_identity_matrix(&_measure.cairo_context());
+      _measure.pre_scale(hdpi_scale());
+      context ctx { *this, _measure, &_main_element, _current_bounds };
+
+      f(ctx, _main_element);
+
+      _measure.restore();
    }
 
    namespace
    {
-      template <typename F, typename This>
-      void call(F f, This& self, rect _current_bounds)
+      // The same layer: the same element, or keyed elements of the same key
+      bool same_layer(element const& prev, element const& next)
       {
-         auto surface_ = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
-         auto context_ = cairo_create(surface_);
-         canvas cnv{ *context_ };
-         cnv.pre_scale(self.hdpi_scale());
-         context ctx { self, cnv, &self.main_element(), _current_bounds };
+         if (&prev == &next)
+            return true;
+         auto* prev_k = dynamic_cast<keyed_element const*>(&prev);
+         auto* next_k = dynamic_cast<keyed_element const*>(&next);
+         return prev_k && next_k && prev_k->key() == next_k->key();
+      }
+   }
 
-         f(ctx, self.main_element());
+   void view::reconcile_content(std::vector<element_ptr> next)
+   {
+      // Deferred, to give the trigger that initiated this call (e.g. button
+      // on_click) a chance to return before it is replaced.
+      post(
+         [next = std::move(next), this]() mutable
+         {
+            std::reverse(next.begin(), next.end());
+            elements::reconcile(_content, next);
 
-         cairo_surface_destroy(surface_);
-         cairo_destroy(context_);
-      }
+            // The layers' focus and tracking state goes to the same layers
+            // in next, wherever they are.
+            std::vector<std::pair<std::size_t, std::size_t>> moved;
+            std::vector<bool> taken(next.size(), false);
+            for (std::size_t i = 0; i != _content.size(); ++i)
+            {
+               for (std::size_t j = 0; j != next.size(); ++j)
+               {
+                  if (!taken[j] && same_layer(*_content[i], *next[j]))
+                  {
+                     moved.emplace_back(i, j);
+                     taken[j] = true;
+                     break;
+                  }
+               }
+            }
+
+            end_focus();
+            layer_composite prev = _content;
+            _content = std::move(next);
+            _content.invalidate_limits();
+            _content.reset();
+            for (auto [from, to] : moved)
+               _content.take_state(prev, from, to);
+            set_limits();
+            layout();
+            begin_focus();
+         }
+      );
    }
 
    void view::layout()
@@ -112,9 +298,11 @@
       if (_current_bounds.is_empty())
          return;
 
+      ELEMENTS_TRACE_ZONE("layout", "view::layout");
+      _drawn.clear();
+      _last_hit_depth = 0;
       call(
-         [](auto const& ctx, auto& _main_element) { _main_element.layout(ctx); },
-         *this, _current_bounds
+         [](auto const& ctx, auto& _main_element) { _main_element.layout(ctx); }
       );
 
       refresh();
@@ -125,9 +313,11 @@
       if (_current_bounds.is_empty())
          return;
 
+      ELEMENTS_TRACE_ZONE("layout", "view::layout");
+      _drawn.clear();
+      _last_hit_depth = 0;
       call(
-         [](auto const& ctx, auto& _main_element) { _main_element.layout(ctx); },
-         *this, _current_bounds
+         [](auto const& ctx, auto& _main_element) { _main_element.layout(ctx); }
       );
 
       refresh(element);
@@ -147,23 +337,27 @@
    void view::refresh()
    {
       // Allow refresh to be called from another thread
-      _io.post(
-         [this]()
-         {
-            base_view::refresh();
-         }
-      );
+      bool schedule;
+      {
+         std::lock_guard<std::mutex> lock(_request_mutex);
+         _damage_all = true;
+         schedule = !std::exchange(_flush_posted, true);
+      }
+      if (schedule)
+         post([this]() { flush_damage(); });
    }
 
    void view::refresh(rect area)
    {
       // Allow refresh to be called from another thread
-      _io.post(
-         [this, area]()
-         {
-            base_view::refresh(area);
-         }
-      );
+      bool schedule;
+      {
+         std::lock_guard<std::mutex> lock(_request_mutex);
+         _damage.add(area);
+         schedule = !std::exchange(_flush_posted, true);
+      }
+      if (schedule)
+         post([this]() { flush_damage(); });
    }
 
    void view::refresh(element& element, int outward)
@@ -171,22 +365,560 @@
       if (_current_bounds.is_empty())
          return;
 
-      _io.post(
-         [this, &element, outward]()
+      // Allow refresh to be called from another thread
+      bool schedule;
+      {
+         std::lock_guard<std::mutex> lock(_request_mutex);
+         _pending_refresh.emplace_back(&element, outward);
+         schedule = !std::exchange(_flush_posted, true);
+      }
+      if (schedule)
+         post([this]() { flush_damage(); });
+   }
+
+   void view::flush_damage()
+   {
+      // All the refreshes requested since the last flush are handled here,
+      // with a single task. First, find where the refreshed elements are.
+      std::vector<pending_refresh> pending;
+      {
+         std::lock_guard<std::mutex> lock(_request_mutex);
+         pending.swap(_pending_refresh);
+      }
+
+      std::sort(pending.begin(), pending.end());
+      pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+
+      for (auto [e, outward] : pending)
+      {
+         // Refresh where the element was drawn, if we know it. Otherwise,
+         // search the element tree (this calls refresh(rect)).
+         if (auto bounds = drawn_bounds(*e, outward))
+         {
+            std::lock_guard<std::mutex> lock(_request_mutex);
+            _damage.add(*bounds);
+         }
+         else
          {
             call(
-               [&element, outward](auto const& ctx, auto& _main_element)
+               [e = e, outward = outward](auto const& ctx, auto& _main_element)
                {
-                  _main_element.refresh(ctx, element, outward);
-               },
-               *this, _current_bounds
+                  _main_element.refresh(ctx, *e, outward);
+               }
             );
          }
+      }
+
+      // Then hand the accumulated damage to the host
+      damage_region damage{ _damage.max_rects() };
+      bool all;
+      {
+         std::lock_guard<std::mutex> lock(_request_mutex);
+         damage.swap(_damage);
+         all = std::exchange(_damage_all, false);
+         _flush_posted = false;
+      }
+
+      if (all)
+      {
+         auto size_ = size();
+         auto scale_ = hdpi_scale();
+         _frame_damage.add(rect{ 0, 0, size_.width * scale_, size_.height * scale_ });
+         base_view::refresh();
+      }
+      else if (!damage.empty())
+      {
+         _frame_damage.add(damage);
+         for (std::size_t i = 0; i != damage.size(); ++i)
+            base_view::refresh(damage[i]);
+      }
+   }
+
+   void view::request_frame(frame_callback f)
+   {
+      bool first;
+      {
+         std::lock_guard<std::mutex> lock(_request_mutex);
+         first = _frame_callbacks.empty();
+         _frame_callbacks.push_back(std::move(f));
+      }
+      if (first)
+         post([this]() { schedule_frame(); });
+   }
+
+   void view::schedule_frame()
+   {
+      if (request_tick() || _frame_timer_set)
+         return;
+
+      // No frame clock: tick at a fixed rate
+      auto now = std::chrono::steady_clock::now();
+      _frame_timer_set = true;
+      _frame_timer.expires_at(std::max(now, _last_tick + frame_period));
+      _frame_timer.async_wait(
+         [this](auto const& err)
+         {
+            _frame_timer_set = false;
+            if (!err)
+               tick(std::chrono::steady_clock::now());
+         }
       );
+      schedule_poll(_frame_timer.expiry());
+   }
+
+   void view::tick(frame_time time)
+   {
+      _last_tick = time;
+      std::vector<frame_callback> callbacks;
+      {
+         std::lock_guard<std::mutex> lock(_request_mutex);
+         callbacks.swap(_frame_callbacks);
+      }
+
+      // Callbacks may request the next frame
+      for (auto& f : callbacks)
+         f(time);
+   }
+
+   void view::max_damage_rects(std::size_t n)
+   {
+      std::lock_guard<std::mutex> lock(_request_mutex);
+      _damage.max_rects(n);
+      _frame_damage.max_rects(n);
+      _draw_damage.max_rects(n);
+   }
+
+   rect const* view::drawn_bounds(element const& e, int outward) const
+   {
+      // Going outward, skip the ancestors that were not drawn with their
+      // own context (e.g. indirect elements), as refresh(ctx, outward) does.
+      auto&& find =
+         [this](element const* p)
+         {
+            auto i = _drawn.find(p);
+            if (i != _drawn.end() && i->second.anchor.expired())
+               return _drawn.end();
+            return i;
+         };
+
+      element const* p = &e;
+      auto i = find(p);
+      if (i == _drawn.end())
+         return nullptr;
+
+      while (outward-- > 0)
+      {
+         do
+         {
+            p = p->parent();
+            if (!p)
+               return nullptr;
+            i = find(p);
+         }
+         while (i == _drawn.end());
+      }
+      return i->second.shared? nullptr : &i->second.bounds;
+   }
+
+   void view::count_drawn(std::size_t drawn, std::size_t culled)
+   {
+      if (auto* scope = current_scope)
+      {
+         scope->drawn += drawn;
+         scope->culled += culled;
+      }
+   }
+
+   void view::note_drawn(context const& ctx)
+   {
+      // Only what is drawn on the view counts, not offscreen renderings
+      auto* scope = current_scope;
+      if (!scope || &ctx.canvas != scope->cnv)
+         return;
+
+      scope->elements.emplace_back(ctx.element, device_bounds(ctx, *scope));
+   }
+
+   rect view::device_bounds(context const& ctx, draw_scope const& scope)
+   {
+      // In a band, the canvas' device space is the band's pixels: move
+      // them to the view's pixels, then scale them to its device space.
+      auto tl = ctx.canvas.user_to_device(ctx.bounds.left_top());
+      auto br = ctx.canvas.user_to_device(ctx.bounds.right_bottom());
+      return {
+         (tl.x + scope.pixel_origin.x) * scope.scale.x
+       , (tl.y + scope.pixel_origin.y) * scope.scale.y
+       , (br.x + scope.pixel_origin.x) * scope.scale.x
+       , (br.y + scope.pixel_origin.y) * scope.scale.y
+      };
+   }
+
+   void view::merge(draw_scope const& scope)
+   {
+      _frame.visited += scope.drawn + scope.culled;
+      _frame.drawn += scope.drawn;
+      _frame.culled += scope.culled;
+
+      // An element drawn more than once in a frame is shared, unless it is
+      // the same element drawn in adjacent tiles.
+      auto&& same =
+         [](rect const& a, rect const& b)
+         {
+            return std::abs(a.left - b.left) < 0.5f && std::abs(a.top - b.top) < 0.5f
+               && std::abs(a.right - b.right) < 0.5f && std::abs(a.bottom - b.bottom) < 0.5f;
+         };
+
+      for (auto const& [e, bounds] : scope.elements)
+      {
+         auto& info = _drawn[e];
+         if (info.anchor.expired())
+         {
+            // New, or the address of a destroyed element
+            info = {};
+            info.anchor = e->anchor();
+         }
+         else if (info.frame == _draw_count && !same(info.bounds, bounds))
+            info.shared = true;
+         info.bounds = bounds;
+         info.frame = _draw_count;
+      }
+   }
+
+   void view::draw_child(element& e, context const& ctx)
+   {
+      auto* scope = current_scope;
+      if (!_drawing_tiles || !scope)
+      {
+         e.draw(ctx);
+      }
+      else if (&ctx.canvas != scope->cnv)
+      {
+         // Drawn offscreen, by an element drawn concurrently
+         if (e.concurrent_draw())
+         {
+            e.draw(ctx);
+         }
+         else
+         {
+            std::lock_guard<std::recursive_mutex> lock(_draw_mutex);
+            e.draw(ctx);
+         }
+      }
+      else if (!e.concurrent_draw())
+      {
+         defer(e, ctx, *scope);
+      }
+      else
+      {
+         // Elements drawn after a deferred element that overlap it are
+         // deferred too, to be drawn over it
+         if (!scope->deferred.empty())
+         {
+            auto bounds = device_bounds(ctx, *scope);
+            for (auto const& d : scope->deferred)
+            {
+               if (d.device_bounds.is_intersects(bounds))
+               {
+                  defer(e, ctx, *scope);
+                  return;
+               }
+            }
+         }
+         e.draw(ctx);
+      }
+   }
+
+   void view::defer(element& e, context const& ctx, draw_scope& scope)
+   {
+      deferred_draw d;
+      d.e = &e;
+      d.bounds = ctx.bounds;
+      d.device_bounds = device_bounds(ctx, scope);
+
+      // The transform to the band's pixels, then to the view's pixels
+      auto& cr = ctx.canvas.cairo_context();
+      cairo_matrix_t to_view;
+      cairo_get_matrix(&cr, &d.matrix);
+      cairo_matrix_init_translate(&to_view, scope.pixel_origin.x, scope.pixel_origin.y);
+      cairo_matrix_multiply(&d.matrix, &d.matrix, &to_view);
+
+      auto* clip = cairo_copy_clip_rectangle_list(&cr);
+      if (clip->status == CAIRO_STATUS_SUCCESS)
+      {
+         d.clipped = true;
+         for (int i = 0; i != clip->num_rectangles; ++i)
+         {
+            auto const& r = clip->rectangles[i];
+            d.clip.push_back({
+               static_cast<rect::coordinate_type>(r.x)
+             , static_cast<rect::coordinate_type>(r.y)
+             , static_cast<rect::coordinate_type>(r.x + r.width)
+             , static_cast<rect::coordinate_type>(r.y + r.height)
+            });
+         }
+      }
+      cairo_rectangle_list_destroy(clip);
+      scope.deferred.push_back(std::move(d));
+   }
+
+   void view::draw_deferred(cairo_t* context_, std::vector<draw_scope*> const& scopes, double dsx, double dsy)
+   {
+      // An element that spans several bands is deferred by each of them,
+      // clipped to each band: draw it once, clipped to all of them. Each
+      // band's list is in drawing order, and elements that overlap are
+      // both in the bands where they overlap: draw the elements in an
+      // order consistent with all the bands' lists.
+      auto&& same =
+         [](deferred_draw const& a, deferred_draw const& b)
+         {
+            auto const& p = a.device_bounds;
+            auto const& q = b.device_bounds;
+            return a.e == b.e
+               && std::abs(p.left - q.left) < 0.5f && std::abs(p.top - q.top) < 0.5f
+               && std::abs(p.right - q.right) < 0.5f && std::abs(p.bottom - q.bottom) < 0.5f;
+         };
+
+      constexpr auto none = std::size_t(-1);
+      std::vector<deferred_draw> items;
+      std::vector<std::vector<std::size_t>> after;   // the items drawn after each item
+      std::vector<std::size_t> num_before;
+      for (auto* scope : scopes)
+      {
+         auto prev = none;
+         for (auto const& d : scope->deferred)
+         {
+            auto i = std::find_if(items.begin(), items.end(),
+               [&](auto const& item) { return same(item, d); });
+            auto index = std::size_t(i - items.begin());
+            if (i == items.end())
+            {
+               items.push_back(d);
+               after.emplace_back();
+               num_before.push_back(0);
+            }
+            else
+            {
+               i->clipped = i->clipped && d.clipped;
+               i->clip.insert(i->clip.end(), d.clip.begin(), d.clip.end());
+            }
+
+            if (prev != none && prev != index)
+            {
+               after[prev].push_back(index);
+               ++num_before[index];
+            }
+            prev = index;
+         }
+      }
+      if (items.empty())
+         return;
+
+      // Topological order, favoring the order the items were found in
+      std::vector<std::size_t> order;
+      std::set<std::size_t> ready;
+      for (std::size_t i = 0; i != items.size(); ++i)
+         if (num_before[i] == 0)
+            ready.insert(i);
+      while (!ready.empty())
+      {
+         auto i = *ready.begin();
+         ready.erase(ready.begin());
+         order.push_back(i);
+         for (auto j : after[i])
+            if (--num_before[j] == 0)
+               ready.insert(j);
+      }
+
+      // The bands' lists cannot disagree, but if they do, draw the rest
+      // in the order they were found
+      if (order.size() != items.size())
+      {
+         for (std::size_t i = 0; i != items.size(); ++i)
+            if (std::find(order.begin(), order.end(), i) == order.end())
+               order.push_back(i);
+      }
+
+      ELEMENTS_TRACE_ZONE("draw", "view::draw_deferred");
+      cairo_matrix_t to_context;
+      cairo_matrix_init_scale(&to_context, 1 / dsx, 1 / dsy);
+
+      draw_scope scope;
+      for (auto i : order)
+      {
+         auto const& d = items[i];
+         cairo_save(context_);
+         {
+            canvas cnv{ *context_ };
+            cnv.pre_scale(hdpi_scale());
+
+            cairo_matrix_t m;
+            cairo_matrix_multiply(&m, &d.matrix, &to_context);
+            cairo_set_matrix(context_, &m);
+            if (d.clipped)
+            {
+               for (auto const& r : d.clip)
+                  cairo_rectangle(context_, r.left, r.top, r.width(), r.height());
+               cairo_clip(context_);
+            }
+
+            scope.cnv = &cnv;
+            current_scope = &scope;
+            context ctx{ *this, cnv, d.e, d.bounds };
+            d.e->draw(ctx);
+            current_scope = nullptr;
+            scope.cnv = nullptr;
+         }
+         cairo_restore(context_);
+      }
+      merge(scope);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Tiled rendering
+   ////////////////////////////////////////////////////////////////////////////
+   void view::draw_threads(std::size_t n)
+   {
+      _draw_threads = std::max<std::size_t>(n, 1);
+      _workers.reset();
+      if (_draw_threads > 1)
+         _workers = std::make_unique<draw_workers>(_draw_threads - 1);
+   }
+
+   bool view::draw_tiles(cairo_t* context_, rect subj_bounds)
+   {
+      // Tiles are drawn in pixels: only plain scaling and translation. m is
+      // the transform of the host's context, before the view's pre_scale.
+      auto dpi = hdpi_scale();
+      cairo_matrix_t m;
+      cairo_get_matrix(context_, &m);
+      if (m.xy != 0 || m.yx != 0 || m.xx <= 0 || m.yy <= 0)
+         return false;
+      cairo_matrix_scale(&m, 1 / dpi, 1 / dpi);
+
+      double dsx, dsy;
+      cairo_surface_get_device_scale(cairo_get_target(context_), &dsx, &dsy);
+
+      // The area to draw, in pixels
+      double x1, y1, x2, y2;
+      cairo_clip_extents(context_, &x1, &y1, &x2, &y2);
+      cairo_user_to_device(context_, &x1, &y1);
+      cairo_user_to_device(context_, &x2, &y2);
+      int left = static_cast<int>(std::floor(x1 * dsx));
+      int top = static_cast<int>(std::floor(y1 * dsy));
+      int right = static_cast<int>(std::ceil(x2 * dsx));
+      int bottom = static_cast<int>(std::ceil(y2 * dsy));
+
+      // Not worth it for small areas
+      constexpr int min_tiled_area = 512 * 512;
+      constexpr int min_band_height = 32;
+      int width = right - left;
+      int height = bottom - top;
+      if (width <= 0 || height <= 0 || width * height < min_tiled_area)
+         return false;
+
+      // The damage may be made of several rectangles: clip the tiles to it
+      auto* clip = cairo_copy_clip_rectangle_list(context_);
+      if (clip->status != CAIRO_STATUS_SUCCESS)
+      {
+         cairo_rectangle_list_destroy(clip);
+         return false;
+      }
+
+      struct band
+      {
+         int top = 0;
+         int height = 0;
+         cairo_surface_t* surface = nullptr;
+         draw_scope scope;
+      };
+
+      auto num_bands = _draw_threads * 2;
+      int band_height = std::max<int>(min_band_height, (height + num_bands - 1) / num_bands);
+      std::vector<band> bands;
+      bands.resize((height + band_height - 1) / band_height);
+      for (std::size_t i = 0; i != bands.size(); ++i)
+      {
+         bands[i].top = top + int(i) * band_height;
+         bands[i].height = std::min(band_height, bottom - bands[i].top);
+      }
+
+      std::vector<std::function<void()>> jobs;
+      for (auto& b_ : bands)
+      {
+         jobs.push_back(
+            [&, bp = &b_]()
+            {
+               auto& b = *bp;
+               ELEMENTS_TRACE_ZONE("draw", "view::draw_tiles band");
+               b.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, b.height);
+               auto* cr = cairo_create(b.surface);
+
+               // From the band's pixels to the view's user space
+               cairo_translate(cr, -left, -b.top);
+               cairo_scale(cr, dsx, dsy);
+               cairo_transform(cr, &m);
+               {
+                  canvas cnv{ *cr };
+                  cnv.pre_scale(dpi);
+                  for (int i = 0; i != clip->num_rectangles; ++i)
+                  {
+                     auto const& r = clip->rectangles[i];
+                     cairo_rectangle(cr, r.x, r.y, r.width, r.height);
+                  }
+                  cairo_clip(cr);
+                  context ctx{ *this, cnv, &_main_element, subj_bounds };
+
+                  // The band's device space is in pixels, offset by the
+                  // band's position
+                  b.scope.cnv = &cnv;
+                  b.scope.pixel_origin = { float(left), float(b.top) };
+                  b.scope.scale = { float(1 / dsx), float(1 / dsy) };
+                  current_scope = &b.scope;
+                  _main_element.draw(ctx);
+                  current_scope = nullptr;
+                  b.scope.cnv = nullptr;
+               }
+               cairo_destroy(cr);
+               cairo_surface_flush(b.surface);
+            }
+         );
+      }
+
+      _drawing_tiles = true;
+      _workers->run(jobs);
+      _drawing_tiles = false;
+      cairo_rectangle_list_destroy(clip);
+
+      // Composite the bands, in pixel space
+      std::vector<draw_scope*> scopes;
+      cairo_save(context_);
+      cairo_identity_matrix(context_);
+      cairo_scale(context_, 1 / dsx, 1 / dsy);
+      for (auto& b : bands)
+      {
+         cairo_set_source_surface(context_, b.surface, left, b.top);
+         cairo_rectangle(context_, left, b.top, width, b.height);
+         cairo_fill(context_);
+         cairo_surface_destroy(b.surface);
+         merge(b.scope);
+         scopes.push_back(&b.scope);
+      }
+      cairo_restore(context_);
+
+      // Then draw what the bands left for this thread, over them
+      draw_deferred(context_, scopes, dsx, dsy);
+      return true;
    }
 
    void view::refresh(context const& ctx, int outward)
    {
+      // What the retained elements the context is in kept is stale
+      for (auto p = &ctx; p; p = p->parent)
+      {
+         if (auto* r = dynamic_cast<retained_element*>(p->element))
+            r->invalidate();
+      }
+
       context const* ctx_ptr = &ctx;
       while (outward > 0 && ctx_ptr)
       {
@@ -201,63 +933,226 @@
       }
    }
 
+   void view::scroll_refresh(context const& ctx, point offset)
+   {
+      // Refresh ctx.bounds, whose content has moved by offset. If the host
+      // can, it shifts the rendered pixels and redraws only the exposed
+      // parts. Posted to keep it in order with the other refreshes.
+      auto tl = ctx.canvas.user_to_device(ctx.bounds.left_top());
+      auto br = ctx.canvas.user_to_device(ctx.bounds.right_bottom());
+      auto moved = ctx.canvas.user_to_device(ctx.bounds.left_top().move(offset.x, offset.y));
+      rect area = { tl.x, tl.y, br.x, br.y };
+      point device_offset = { moved.x - tl.x, moved.y - tl.y };
+
+      post(
+         [this, area, device_offset]()
+         {
+            // Damage requested before scrolling moves with the pixels
+            flush_damage();
+            if (scroll_area(area, device_offset))
+            {
+               // What was drawn in the area moved without being drawn again
+               for (auto i = _drawn.begin(); i != _drawn.end();)
+               {
+                  if (i->second.bounds.is_intersects(area))
+                     i = _drawn.erase(i);
+                  else
+                     ++i;
+               }
+            }
+            else
+            {
+               base_view::refresh(area);
+            }
+         }
+      );
+   }
+
    void view::click(mouse_button btn)
    {
+      // Deliver the motion that happened before the click first
+      flush_motion();
+
       _current_button = btn;
       if (_content.empty())
          return;
 
+      ELEMENTS_TRACE_ZONE("event", "view::click");
       call(
          [btn, this](auto const& ctx, auto& _main_element)
          {
             _main_element.click(ctx, btn);
             _is_focus = _main_element.focus();
-         },
-         *this, _current_bounds
+         }
       );
    }
 
    void view::drag(mouse_button btn)
+   {
+      queue_motion(true, btn);
+   }
+
+   void view::cursor(point p, cursor_tracking status)
+   {
+      if (status == cursor_tracking::hovering)
+      {
+         mouse_button btn;
+         btn.pos = p;
+         queue_motion(false, btn);
+      }
+      else
+      {
+         flush_motion();
+         dispatch_cursor(p, status);
+      }
+   }
+
+   void view::raw_motion(bool raw)
+   {
+      _raw_motion = raw;
+      if (raw)
+         flush_motion();
+   }
+
+   void view::queue_motion(bool drag, mouse_button btn)
+   {
+      // Only the latest motion is dispatched, at most once per frame. The
+      // positions in between are kept in _motion_history.
+      if (_motion_pending && _motion_is_drag != drag)
+         flush_motion();
+
+      _motion = btn;
+      _motion_is_drag = drag;
+      _motion_pending = true;
+      _motion_history.push_back(btn.pos);
+
+      if (_raw_motion)
+      {
+         flush_motion();
+      }
+      else if (!_motion_frame_requested)
+      {
+         _motion_frame_requested = true;
+         request_frame(
+            [this](auto /* time */)
+            {
+               _motion_frame_requested = false;
+               flush_motion();
+            }
+         );
+      }
+   }
+
+   void view::flush_motion()
+   {
+      if (!_motion_pending)
+         return;
+      _motion_pending = false;
+
+      if (_motion_is_drag)
+         dispatch_drag(_motion);
+      else
+         dispatch_cursor(_motion.pos, cursor_tracking::hovering);
+      _motion_history.clear();
+   }
+
+   void view::dispatch_drag(mouse_button btn)
    {
       _current_button = btn;
       if (_content.empty())
          return;
 
+      ELEMENTS_TRACE_ZONE("event", "view::drag");
       call(
          [btn](auto const& ctx, auto& _main_element)
          {
             _main_element.drag(ctx, btn);
-         },
-         *this, _current_bounds
+         }
       );
    }
 
-   void view::cursor(point p, cursor_tracking status)
+   void view::dispatch_cursor(point p, cursor_tracking status)
    {
       if (_content.empty())
          return;
 
+      ELEMENTS_TRACE_ZONE("event", "view::cursor");
+      _hit_depth = 0;
+      _dispatching_cursor = status != cursor_tracking::leaving;
       call(
          [p, status](auto const& ctx, auto& _main_element)
          {
             if (!_main_element.cursor(ctx, p, status))
                set_cursor(cursor_type::arrow);
-         },
-         *this, _current_bounds
+         }
       );
+      _dispatching_cursor = false;
+      _last_hit_depth = _hit_depth;
+   }
+
+   void view::note_hit(element& e, rect bounds, point p)
+   {
+      if (!_dispatching_cursor)
+         return;
+
+      if (_hit_depth == _hit_path.size())
+         _hit_path.emplace_back();
+
+      auto& entry = _hit_path[_hit_depth++];
+      if (entry.e != &e || entry.anchor.expired())
+      {
+         entry.e = &e;
+         entry.anchor = e.anchor();
+      }
+      entry.bounds = bounds;
+      entry.p = p;
+   }
+
+   bool view::still_hit(context const& ctx, element& e, rect bounds, point p)
+   {
+      if (!_dispatching_cursor)
+         return false;
+
+      // Find e in what is left of the last hit path, below the levels
+      // already dispatched to.
+      for (auto i = _hit_depth; i < _last_hit_depth; ++i)
+      {
+         auto const& entry = _hit_path[i];
+         if (entry.e != &e)
+            continue;
+         if (entry.bounds != bounds || entry.anchor.expired())
+            return false;
+
+         // The innermost element stands for the elements between only if
+         // they all passed the cursor down unchanged (e.g. no scroller or
+         // scale in between). If it is hit, so are they.
+         for (auto j = i + 1; j < _last_hit_depth; ++j)
+         {
+            if (_hit_path[j].p != entry.p || _hit_path[j].anchor.expired())
+               return false;
+         }
+
+         auto const& leaf = _hit_path[_last_hit_depth - 1];
+         if (!leaf.bounds.includes(p))
+            return false;
+         context lctx{ ctx, leaf.e, leaf.bounds };
+         return leaf.e->hit_test(lctx, p) != nullptr;
+      }
+      return false;
    }
 
    void view::scroll(point dir, point p)
    {
+      flush_motion();
       if (_content.empty())
          return;
 
+      ELEMENTS_TRACE_ZONE("event", "view::scroll");
       call(
          [dir, p](auto const& ctx, auto& _main_element)
          {
             _main_element.scroll(ctx, dir, p);
-         },
-         *this, _current_bounds
+         }
       );
    }
 
@@ -267,12 +1162,12 @@
          return false;
 
       bool handled = false;
+      ELEMENTS_TRACE_ZONE("event", "view::key");
       call(
          [k, &handled](auto const& ctx, auto& _main_element)
          {
              handled = _main_element.key(ctx, k);
-         },
-         *this, _current_bounds
+         }
       );
       return handled;
    }
@@ -283,34 +1178,80 @@
          return false;
 
       bool handled = false;
+      ELEMENTS_TRACE_ZONE("event", "view::text");
       call(
          [info, &handled](auto const& ctx, auto& _main_element)
          {
              handled = _main_element.text(ctx, info);
-         },
-         *this, _current_bounds
+         }
       );
       return handled;
    }
 
-   void view::add_undo(undo_redo_task f)
+   namespace
    {
-      _undo_stack.push(f);
+      std::size_t memory_of(view::undo_redo_task const& t)
+      {
+         return sizeof(view::undo_redo_task) + t.size;
+      }
+   }
+
+   view::undo_id view::add_undo(undo_redo_task f)
+   {
+      _undo_memory += memory_of(f);
+      _undo_stack.push_back(std::move(f));
       if (has_redo())
       {
          // clear the redo stack
-         undo_stack_type empty{};
-         _redo_stack.swap(empty);
+         for (auto const& t : _redo_stack)
+            _undo_memory -= memory_of(t);
+         _redo_stack.clear();
       }
+      trim_undo();
+      return _newest_undo_id = ++_last_undo_id;
+   }
+
+   bool view::grow_undo(undo_id id, std::size_t bytes)
+   {
+      if (id == 0 || id != _newest_undo_id || !has_undo())
+         return false;
+      _undo_stack.back().size += bytes;
+      _undo_memory += bytes;
+      trim_undo();
+      return true;
+   }
+
+   void view::clear_undo(void const* owner)
+   {
+      auto clear = [this, owner](undo_stack_type& stack)
+      {
+         for (auto const& t : stack)
+         {
+            if (t.owner == owner)
+               _undo_memory -= memory_of(t);
+         }
+         stack.erase(
+            std::remove_if(stack.begin(), stack.end(),
+               [owner](auto const& t) { return t.owner == owner; }
+            )
+          , stack.end()
+         );
+      };
+
+      if (has_undo() && _undo_stack.back().owner == owner)
+         _newest_undo_id = 0;
+      clear(_undo_stack);
+      clear(_redo_stack);
    }
 
    bool view::undo()
    {
       if (has_undo())
       {
-         auto t = _undo_stack.top();
-         _undo_stack.pop();
-         _redo_stack.push(t);
+         auto t = _undo_stack.back();
+         _undo_stack.pop_back();
+         _newest_undo_id = 0;
+         _redo_stack.push_back(t);
          t.undo();  // execute undo function
          return true;
       }
@@ -321,15 +1262,38 @@
    {
       if (has_redo())
       {
-         auto t = _redo_stack.top();
-         _undo_stack.push(t);
-         _redo_stack.pop();
+         auto t = _redo_stack.back();
+         _undo_stack.push_back(t);
+         _newest_undo_id = 0;
+         _redo_stack.pop_back();
          t.redo();  // execute redo function
          return true;
       }
       return false;
    }
 
+   void view::undo_limit(std::size_t bytes)
+   {
+      _undo_limit = bytes;
+      trim_undo();
+   }
+
+   void view::trim_undo()
+   {
+      // Drop the oldest undo tasks first, then the redo tasks farthest from
+      // the present, keeping the newest undo task.
+      while (_undo_memory > _undo_limit && _undo_stack.size() > 1)
+      {
+         _undo_memory -= memory_of(_undo_stack.front());
+         _undo_stack.pop_front();
+      }
+      while (_undo_memory > _undo_limit && !_redo_stack.empty())
+      {
+         _undo_memory -= memory_of(_redo_stack.front());
+         _redo_stack.pop_front();
+      }
+   }
+
    void view::begin_focus()
    {
       if (_content.empty() || !_is_focus)
@@ -355,13 +1319,21 @@
       {
          using namespace std::chrono_literals;
          auto now = std::chrono::steady_clock::now();
-         if ((now - _tracking_time) > 1s)
+         if ((now - _tracking_time) >= 1s)
          {
             on_tracking(*_tracking_element, tracking::end_tracking);
             _tracking_time = now;
             _tracking_element = nullptr;
             _tracking_state = tracking::none;
          }
+         else if (now >= _tracking_deadline)
+         {
+            // Still tracking, and the scheduled check has passed: come back
+            // when the tracking times out. Other polls in between do not
+            // need another deadline.
+            _tracking_deadline = _tracking_time + 1s;
+            schedule_poll(_tracking_deadline);
+         }
       }
    }
 
@@ -375,9 +1347,20 @@
          _tracking_element && _tracking_element != &e)
          on_tracking(*_tracking_element, tracking::end_tracking);
 
+      bool was_tracking = _tracking_state != tracking::none;
       _tracking_element = &e;
       _tracking_state = state;
       _tracking_time = std::chrono::steady_clock::now();
       on_tracking(e, state);
+
+      // poll() ends the tracking after 1s of inactivity. The check is
+      // scheduled once here, and again by poll() only when it finds that
+      // the tracking went on past it.
+      if (!was_tracking)
+      {
+         using namespace std::chrono_literals;
+         _tracking_deadline = _tracking_time + 1s;
+         schedule_poll(_tracking_deadline);
+      }
    }
 }}
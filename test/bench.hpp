@@ -0,0 +1,38 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_TEST_BENCH_OCTOBER_17_2026)
+#define ELEMENTS_TEST_BENCH_OCTOBER_17_2026
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+namespace bench
+{
+	////////////////////////////////////////////////////////////////////////////
+	// Minimal timing for the benchmarks: f is called once to warm up, then
+	// n times. Returns the average time per call in nanoseconds.
+	////////////////////////////////////////////////////////////////////////////
+	template <typename F>
+	double time_per_call(std::size_t n, F f)
+	{
+		using clock = std::chrono::steady_clock;
+		f();
+		auto start = clock::now();
+		for (std::size_t i = 0; i != n; ++i)
+			f();
+		std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+		return elapsed.count() / n;
+	}
+
+	// Prints the time per call, and the calls per second it allows
+	inline void report(const char* name, double ns)
+	{
+		std::printf("%-40s %12.1f ns %14.0f /s\n", name, ns, 1e9 / ns);
+	}
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#include <elements.hpp>
+#include <elements/support/detail/scratch_context.hpp>
+#include "bench.hpp"
+#include <string>
+#include <vector>
+
+using namespace cycfi::elements;
+
+// element_cast answers the casts to the library's base classes with the
+// element's type queries. Compare that with dynamic_cast, for elements
+// that are of the type asked for, and elements that are not (the common
+// case when searching the tree). Then time scrollable::find, which text
+// boxes call on each keystroke, from the bottom of a context chain.
+
+namespace
+{
+	constexpr std::size_t iterations = 10000000;
+
+	// Keeps the compiler from folding the casts away
+	void const* volatile sink;
+
+	template <typename T>
+	void keep(T* p)
+	{
+		sink = p;
+	}
+
+	template <typename Ptr>
+	void compare(const char* name, element* e)
+	{
+		std::string label = name;
+		bench::report((label + ", element_cast").c_str(), bench::time_per_call(iterations,
+			[&]{ keep(element_cast<Ptr>(e)); }
+		));
+		bench::report((label + ", dynamic_cast").c_str(), bench::time_per_call(iterations,
+			[&]{ keep(dynamic_cast<Ptr>(e)); }
+		));
+	}
+
+	// The contexts of a path down from root, depth levels deep, through
+	// middle elements, with the leaf at the bottom
+	template <typename F>
+	void with_context_chain(element& root, element& middle, element& leaf, std::size_t depth, F f)
+	{
+		view view_(extent{ 800, 600 });
+		detail::scratch_context scratch;
+		canvas cnv{ *scratch.context() };
+		rect bounds{ 0, 0, 800, 600 };
+
+		std::vector<std::unique_ptr<context>> chain;
+		chain.push_back(std::make_unique<context>(view_, cnv, &root, bounds));
+		for (std::size_t i = 1; i != depth; ++i)
+		{
+			auto* e = (i + 1 == depth)? &leaf : &middle;
+			chain.push_back(std::make_unique<context>(*chain.back(), e, bounds));
+		}
+		f(*chain.back());
+	}
+}
+
+int main()
+{
+	auto leaf = share(margin({ 2, 2, 2, 2 }, box(colors::gray[50])));
+	auto rows = share(vtile(hold(leaf), hold(leaf)));
+	auto scroller = share(vscroller(hold(rows)));
+
+	// The element pointers are laundered through a volatile so that the
+	// dynamic types are not known to the compiler.
+	element* volatile leaf_ptr = leaf.get();
+	element* volatile rows_ptr = rows.get();
+	element* volatile scroller_ptr = scroller.get();
+
+	compare<proxy_base*>("proxy, hit", leaf_ptr);
+	compare<proxy_base*>("proxy, miss", rows_ptr);
+	compare<composite_base*>("composite, hit", rows_ptr);
+	compare<composite_base*>("composite, miss", leaf_ptr);
+	compare<scrollable*>("scrollable, hit", scroller_ptr);
+	compare<scrollable*>("scrollable, miss", leaf_ptr);
+
+	// Found at the top of a chain of 12 contexts, and not found at all
+	constexpr std::size_t depth = 12;
+	with_context_chain(*scroller, *rows, *leaf, depth, [](context const& ctx)
+	{
+		bench::report("scrollable::find, found", bench::time_per_call(iterations,
+			[&]{ keep(scrollable::find(ctx).scrollable_ptr); }
+		));
+	});
+	with_context_chain(*rows, *rows, *leaf, depth, [](context const& ctx)
+	{
+		bench::report("scrollable::find, not found", bench::time_per_call(iterations,
+			[&]{ keep(scrollable::find(ctx).scrollable_ptr); }
+		));
+	});
+	return 0;
+}
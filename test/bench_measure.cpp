@@ -0,0 +1,124 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#include <elements.hpp>
+#include <elements/support/detail/scratch_context.hpp>
+#include "bench.hpp"
+
+using namespace cycfi::elements;
+
+// Event dispatch and limits computation measure against the view's
+// persistent scratch canvas. Compare that with creating a recording
+// surface and canvas for each event, as was done before. Both sides
+// dispatch to the view's main element the same way view::call does, so
+// that only the canvas differs. The rates are events per second.
+
+namespace
+{
+	constexpr std::size_t iterations = 100000;
+
+	auto make_content()
+	{
+		auto rows = std::make_shared<vtile_composite>();
+		for (int i = 0; i != 200; ++i)
+			rows->push_back(share(margin({ 2, 2, 2, 2 }, box(colors::gray[i % 100]))));
+		return rows;
+	}
+
+	template <typename F>
+	void dispatch(view& view_, canvas& cnv, F f)
+	{
+		cnv.save();
+		cnv.begin_path();
+		cairo_identity_matrix(&cnv.cairo_context());
+		cnv.pre_scale(view_.hdpi_scale());
+		auto size = view_.size();
+		context ctx{ view_, cnv, &view_.main_element(), { 0, 0, size.width, size.height } };
+		f(ctx, view_.main_element());
+		cnv.restore();
+	}
+
+	template <typename F>
+	void with_fresh_canvas(view& view_, F f)
+	{
+		detail::scratch_context scratch;
+		canvas cnv{ *scratch.context() };
+		dispatch(view_, cnv, f);
+	}
+}
+
+int main()
+{
+	view view_(extent{ 800, 600 });
+	auto rows = make_content();
+	view_.content(hold(rows));
+	headless::frame(view_);
+
+	point p{ 400, 300 };
+	detail::scratch_context scratch;
+	canvas scratch_cnv{ *scratch.context() };
+
+	bench::report("cursor, scratch canvas", bench::time_per_call(iterations,
+		[&]
+		{
+			dispatch(view_, scratch_cnv, [&](auto const& ctx, auto& e)
+			{
+				e.cursor(ctx, p, cursor_tracking::hovering);
+			});
+		}
+	));
+	bench::report("cursor, fresh canvas", bench::time_per_call(iterations,
+		[&]
+		{
+			with_fresh_canvas(view_, [&](auto const& ctx, auto& e)
+			{
+				e.cursor(ctx, p, cursor_tracking::hovering);
+			});
+		}
+	));
+
+	bench::report("scroll, scratch canvas", bench::time_per_call(iterations,
+		[&]
+		{
+			dispatch(view_, scratch_cnv, [&](auto const& ctx, auto& e)
+			{
+				e.scroll(ctx, { 0, 0 }, p);
+			});
+		}
+	));
+	bench::report("scroll, fresh canvas", bench::time_per_call(iterations,
+		[&]
+		{
+			with_fresh_canvas(view_, [&](auto const& ctx, auto& e)
+			{
+				e.scroll(ctx, { 0, 0 }, p);
+			});
+		}
+	));
+
+	// Invalidating a row discards the cached limits of the rows and all
+	// their ancestors, so each call computes the limits of all the rows.
+	bench::report("limits, scratch canvas", bench::time_per_call(iterations,
+		[&]
+		{
+			rows->at(0).invalidate_limits();
+			scratch_cnv.save();
+			basic_context bctx{ view_, scratch_cnv };
+			view_.main_element().limits(bctx);
+			scratch_cnv.restore();
+		}
+	));
+	bench::report("limits, fresh canvas", bench::time_per_call(iterations,
+		[&]
+		{
+			rows->at(0).invalidate_limits();
+			detail::scratch_context fresh;
+			canvas cnv{ *fresh.context() };
+			basic_context bctx{ view_, cnv };
+			view_.main_element().limits(bctx);
+		}
+	));
+	return 0;
+}
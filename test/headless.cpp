@@ -0,0 +1,108 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#define CATCH_CONFIG_MAIN
+// This version of Catch cannot use SIGSTKSZ with newer glibc
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
+#include <infra/catch.hpp>
+#include <elements.hpp>
+#include <cstdint>
+
+using namespace cycfi::elements;
+
+namespace
+{
+	// Counts the events it gets, and asks to be redrawn on clicks
+	struct probe : element
+	{
+		void draw(const context & /* ctx */) override { ++draws; }
+
+		bool click(const context & ctx, mouse_button btn) override
+		{
+			if (btn.down)
+				++clicks;
+			ctx.view.refresh(ctx);
+			return true;
+		}
+
+		bool key(const context & /* ctx */, key_info k) override
+		{
+			if (k.action == key_action::press)
+				++keys;
+			return true;
+		}
+
+		bool cursor(const context & /* ctx */, point /* p */, cursor_tracking status) override
+		{
+			if (status == cursor_tracking::entering)
+				++entered;
+			return true;
+		}
+
+		bool wants_focus() const override { return true; }
+		bool wants_control() const override { return true; }
+
+		int draws = 0;
+		int clicks = 0;
+		int keys = 0;
+		int entered = 0;
+	};
+
+	std::uint32_t pixel(base_view& view_, int x, int y)
+	{
+		auto* s = headless::surface(view_);
+		cairo_surface_flush(s);
+		auto* row = cairo_image_surface_get_data(s) + y * cairo_image_surface_get_stride(s);
+		return reinterpret_cast<std::uint32_t*>(row)[x] & 0xffffff;
+	}
+}
+
+TEST_CASE("headless frames render only what was refreshed")
+{
+	view view_(extent{ 200, 100 });
+	view_.content(box(colors::red));
+
+	CHECK(headless::frame(view_));
+	CHECK(pixel(view_, 100, 50) == 0xff0000);
+
+	// Nothing was refreshed since
+	CHECK(!headless::frame(view_));
+
+	view_.refresh();
+	CHECK(headless::frame(view_));
+}
+
+TEST_CASE("headless mouse and key events reach the content")
+{
+	view view_(extent{ 200, 100 });
+	auto p = share(probe{});
+	view_.content(hold(p));
+	headless::frame(view_);
+	CHECK(p->draws == 1);
+
+	headless::mouse_move(view_, { 50, 50 });
+	CHECK(p->entered == 1);
+
+	mouse_button btn;
+	btn.pos = { 50, 50 };
+	btn.down = true;
+	btn.num_clicks = 1;
+	headless::click(view_, btn);
+	btn.down = false;
+	headless::click(view_, btn);
+	CHECK(p->clicks == 1);
+
+	// The click refreshed the probe
+	CHECK(headless::frame(view_));
+	CHECK(p->draws == 2);
+
+	// The click gave the probe the focus
+	CHECK(view_.key({ key_code::a, key_action::press, 0 }));
+	CHECK(p->keys == 1);
+
+	headless::mouse_leave(view_);
+	headless::frame(view_);
+	CHECK(p->clicks == 1);
+}
@@ -0,0 +1,198 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#define CATCH_CONFIG_MAIN
+// This version of Catch cannot use SIGSTKSZ with newer glibc
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
+#include <infra/catch.hpp>
+#include <elements/support/piece_table.hpp>
+#include <string>
+#include <utility>
+
+using namespace cycfi::elements;
+using cycfi::string_view;
+
+namespace
+{
+	std::size_t count_pieces(const piece_table & text)
+	{
+		std::size_t n = 0;
+		text.for_each_piece([&](string_view) { ++n; });
+		return n;
+	}
+}
+
+TEST_CASE("piece_table starts with the original text")
+{
+	piece_table empty;
+	CHECK(empty.empty());
+	CHECK(empty.str() == "");
+	CHECK(count_pieces(empty) == 0);
+
+	piece_table text{ "Hello" };
+	CHECK(text.size() == 5);
+	CHECK(text.str() == "Hello");
+	CHECK(text[1] == 'e');
+	CHECK(text.substr(1, 3) == "ell");
+	CHECK(text.substr(3, 100) == "lo");
+	CHECK(text.garbage() == 0);
+	CHECK(count_pieces(text) == 1);
+}
+
+TEST_CASE("piece_table inserts split the pieces")
+{
+	piece_table text{ "Hello World" };
+	text.insert(5, ",");
+	CHECK(text.str() == "Hello, World");
+	CHECK(count_pieces(text) == 3);
+
+	text.insert(0, ">");
+	text.insert(text.size(), "!");
+	text.insert(1000, "?");
+	CHECK(text.str() == ">Hello, World!?");
+	CHECK(text[0] == '>');
+	CHECK(text[7] == ' ');
+	CHECK(text[text.size()-1] == '?');
+	CHECK(text.substr(2, 8) == "ello, Wo");
+}
+
+TEST_CASE("piece_table typing extends the last piece")
+{
+	piece_table text{ "ab" };
+	text.insert(1, "x");
+	auto pieces = count_pieces(text);
+	text.insert(2, "y");
+	text.insert(3, "z");
+	CHECK(text.str() == "axyzb");
+	CHECK(count_pieces(text) == pieces);
+
+	// Typing somewhere else adds a piece
+	text.insert(0, "w");
+	CHECK(text.str() == "waxyzb");
+	CHECK(count_pieces(text) == pieces + 1);
+}
+
+TEST_CASE("piece_table erases and replaces across pieces")
+{
+	piece_table text{ "Hello World" };
+	text.insert(5, ", dear");
+	text.erase(3, 6);
+	CHECK(text.str() == "Helar World");
+
+	text.erase(0, 0);
+	text.erase(100, 1);
+	text.erase(5, 100);
+	CHECK(text.str() == "Helar");
+
+	text.replace(1, 4, "ipp");
+	CHECK(text.str() == "Hipp");
+
+	text.erase(0, text.size());
+	CHECK(text.empty());
+	CHECK(text.str() == "");
+}
+
+TEST_CASE("piece_table merges many pieces in order")
+{
+	piece_table text;
+	std::string expected;
+	for (int i = 0; i != 200; ++i)
+	{
+		auto c = char('a' + i % 26);
+		auto pos = (i * 7) % (expected.size() + 1);
+		text.insert(pos, string_view{ &c, 1 });
+		expected.insert(pos, 1, c);
+	}
+	CHECK(text.str() == expected);
+	CHECK(text.size() == expected.size());
+	for (std::size_t i = 0; i != expected.size(); ++i)
+		REQUIRE(text[i] == expected[i]);
+}
+
+TEST_CASE("piece_table contiguous views stay put")
+{
+	piece_table text{ "one two three" };
+	text.insert(3, "+");
+	text.insert(8, "+");
+
+	// A range of several pieces is copied, leaving garbage
+	auto view = text.contiguous(2, 8);
+	CHECK(view == "e+ two+ ");
+	CHECK(text.garbage() == 8);
+	CHECK(text.str() == "one+ two+ three");
+
+	// A range of one piece is not copied again
+	CHECK(text.contiguous(2, 8).data() == view.data());
+	CHECK(text.garbage() == 8);
+
+	// The view survives edits elsewhere
+	text.insert(0, "zero ");
+	text.erase(text.size() - 5, 5);
+	CHECK(view == "e+ two+ ");
+	CHECK(text.str() == "zero one+ two+ ");
+
+	CHECK(text.contiguous(text.size(), 3).empty());
+	CHECK(text.contiguous(text.size() - 2, 100) == "+ ");
+}
+
+TEST_CASE("piece_table views survive a move")
+{
+	// Short enough for the small string buffer of a std::string
+	piece_table text{ "Hi" };
+	auto view = text.contiguous(0, 2);
+
+	piece_table moved{ std::move(text) };
+	CHECK(moved.contiguous(0, 2).data() == view.data());
+	CHECK(view == "Hi");
+
+	piece_table assigned;
+	assigned = std::move(moved);
+	CHECK(assigned.contiguous(0, 2).data() == view.data());
+	CHECK(view == "Hi");
+}
+
+TEST_CASE("piece_table compact leaves no garbage")
+{
+	piece_table text{ "abcdef" };
+	text.insert(3, "XYZ");
+	text.erase(0, 2);
+	text.contiguous(0, 5);
+	CHECK(text.garbage() > 0);
+
+	text.compact();
+	CHECK(text.garbage() == 0);
+	CHECK(count_pieces(text) == 1);
+	CHECK(text.str() == "cXYZdef");
+
+	text.insert(7, "g");
+	CHECK(text.str() == "cXYZdefg");
+
+	text.erase(0, text.size());
+	text.compact();
+	CHECK(text.empty());
+	CHECK(count_pieces(text) == 0);
+}
+
+TEST_CASE("piece_table assign replaces the text")
+{
+	piece_table text{ "old" };
+	text.insert(3, " text");
+	text.assign("new");
+	CHECK(text.str() == "new");
+	CHECK(text.garbage() == 0);
+	CHECK(count_pieces(text) == 1);
+}
+
+TEST_CASE("text_view compares piece by piece")
+{
+	piece_table text{ "Hello World" };
+	text.insert(5, ",");
+	text_view view{ text };
+	CHECK(view == "Hello, World");
+	CHECK(view != "Hello, World!");
+	CHECK(view != "Hello; World");
+	CHECK(view[5] == ',');
+	CHECK(view.substr(7, 5) == "World");
+}